@@ -1,8 +1,11 @@
 #pragma once
 
 #include "../util/LockLessQ.h"
+#include "Limits.h"
+#include "Stats.h"
 #include <algorithm>
 #include <atomic>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -12,83 +15,401 @@
 #define GUARD_BYTES_COUNT 5
 static const uint8_t gTestGuard[GUARD_BYTES_COUNT] = {0, 0, 0, 0, 0};
 
-typedef struct PoolNode {
-  bool inUse_;// Control Variable
-  void *data_;// Data Chunk
-  PoolNode() = delete;
+struct PointerNode {
+  void *ptr_;
+  std::atomic<PointerNode *> next_;
 
-  explicit PoolNode(bool inUse, void *data) : inUse_(inUse), data_(data) {}
-} PoolNode_t;
+  explicit PointerNode(void *ptr) : ptr_(ptr), next_(nullptr) {}
 
-using PoolNodePtr_t = std::unique_ptr<PoolNode_t>;
-using PoolVec_t = std::vector<PoolNodePtr_t>;
-using PoolVecPtr_t = std::unique_ptr<PoolVec_t>;
+  PointerNode() = delete;
+};
 
-typedef struct ObjectPool {
-  size_t totalCount_ {};// Total Number of Objects Available
-  size_t size_;         // Object Size
-  size_t count_;        // Object Size
-  size_t index_;        // Last accessed Index
+/// @brief One bit per slot, set while the slot is in use
+using Bitmap_t = std::vector<uint64_t>;
+static constexpr size_t bitmapWordBits_ = 64;
+
+/// @brief How an ObjectPool grows once all of its slabs are exhausted
+typedef struct GrowthPolicy {
+  enum Mode {
+	NONE,     // Never grow; fall back to calloc per object
+	FIXED,    // Every new slab has slabVolume_ objects
+	GEOMETRIC,// Every new slab doubles the capacity of the pool
+  };
+
+  Mode mode_;
+  size_t slabVolume_;// Objects in a grown slab (FIXED) or the first grown slab (GEOMETRIC); 0 uses the initial volume
+  size_t maxVolume_; // Cap on objects across all slabs; 0 uses maxGrowthFactor_ x the initial volume
+} GrowthPolicy_t;
+
+/// @brief Where the memory of a slab comes from
+/// @note Huge page backings fall back HUGE_TLB -> HUGE_TRANSPARENT -> RESERVED when the system can't provide them
+enum class SlabBacking {
+  HEAP,            // calloc'ed up front
+  RESERVED,        // Address space reserved with mmap; pages are committed as the high-water mark advances
+  HUGE_TRANSPARENT,// RESERVED, aligned to and committed in huge pages, advised with MADV_HUGEPAGE
+  HUGE_TLB,        // Mapped from the hugetlbfs pool with MAP_HUGETLB
+};
+
+inline const char *slabBackingName(SlabBacking backing) {
+  switch (backing) {
+	case SlabBacking::HEAP: return "heap";
+	case SlabBacking::RESERVED: return "reserved";
+	case SlabBacking::HUGE_TRANSPARENT: return "thp";
+	case SlabBacking::HUGE_TLB: return "hugetlb";
+  }
+  return "unknown";
+}
+
+/// @brief When the slots of a pool are reset to zero
+enum class ZeroPolicy {
+  NONE,      // Never; a slot keeps whatever its previous user left in it
+  ON_ALLOC,  // When handed out, so only slots that are used again get written
+  ON_FREE,   // When returned, so every slot handed out is zeroed already
+  ON_FREE_NT,// ON_FREE with non-temporal stores, which keep the dead slot out of the cache
+};
+
+inline const char *zeroPolicyName(ZeroPolicy policy) {
+  switch (policy) {
+	case ZeroPolicy::NONE: return "none";
+	case ZeroPolicy::ON_ALLOC: return "on-alloc";
+	case ZeroPolicy::ON_FREE: return "on-free";
+	case ZeroPolicy::ON_FREE_NT: return "on-free-nt";
+  }
+  return "unknown";
+}
+
+/// @brief Settings every slab of a pool is created with
+typedef struct PoolConfig {
+  GrowthPolicy_t growth_;
+  SlabBacking backing_;
+  bool numaLocal_ = false;             // Place every slab on the NUMA node of the thread creating it
+  ZeroPolicy zero_ = ZeroPolicy::ON_FREE;
+  bool padded_ = false;                // Align slots to whole cache lines, for objects handed between threads
+} PoolConfig_t;
+
+/// @brief Alignment of a slot when nothing else is asked for, as with malloc
+static constexpr size_t defaultSlotAlign_ = alignof(std::max_align_t);
+
+static constexpr int numaNodeAny_ = -1;
+
+/// @brief One contiguous chunk of slots; slot `i` lives at chunkHead_ + i * size_
+typedef struct Slab {
+  size_t totalCount_;// Total Number of Objects Available
+  size_t size_;      // Object Size
+  size_t count_;     // Number of Objects in Use
+  size_t index_;     // High-water mark; slots at and beyond this index were never dispatched
+  size_t align_;     // Alignment of chunkHead_, and of every slot as size_ is a multiple of it
+  size_t prepared_;  // Slots backed by committed pages
+  size_t hint_;      // Every inUse_ word before this one is full
+  Bitmap_t inUse_;   // In-use bit per slot
+  Bitmap_t full_;    // Bit per inUse_ word, set while the word is full, so the search skips 4096 slots per read
   void *chunkHead_;
   uint8_t *guard_;
-  PoolVecPtr_t pool_;// Vector of Data Nodes
+  SlabBacking backing_;// The backing this slab actually got
+  size_t mapSize_;     // Bytes reserved (mmap backings)
+  size_t committed_;   // Bytes committed (mmap backings)
+  int node_;           // NUMA node the pages are bound to, numaNodeAny_ if unbound
+
+  /// @param align: power of two up to the page size that `size` is a multiple of
+  explicit Slab(size_t volume, size_t size, size_t align = defaultSlotAlign_, SlabBacking backing = SlabBacking::HEAP,
+				int node = numaNodeAny_);
+
+  Slab() = delete;
+
+  ~Slab();
+
+  /// @brief Address of the first byte past the last slot
+  [[nodiscard]] uintptr_t chunkEnd() const {
+	return (uintptr_t)chunkHead_ + (totalCount_ * size_);
+  }
 
-  [[nodiscard]] std::string str() const {
-	std::ostringstream ss;
-	ss << " [ " << std::endl;
-	ss << "\ttotalCount_: " << totalCount_ << std::endl;
-	ss << "\tcount_: " << count_ << std::endl;
-	ss << "\tsize_: " << size_ << std::endl;
-	ss << "\tindex_: " << index_ << std::endl;
-	ss << "]" << std::endl;
-	return ss.str();
+  /// @brief Address of the slot at `index`
+  [[nodiscard]] void *slot(size_t index) const {
+	return (uint8_t *)chunkHead_ + (index * size_);
   }
 
-  explicit ObjectPool(size_t volume, size_t size) {
-	if (size % 64 != 0) {
-	  size += 64;
-	  size = (size - (sizeof(int) * 2));
+  /// @brief Map a pointer inside this slab back to its slot index
+  /// @returns slot index or totalCount_ if `ptr` is not the start of a slot
+  [[nodiscard]] size_t indexOf(const void *ptr) const {
+	const auto offset = (uintptr_t)ptr - (uintptr_t)chunkHead_;
+	if (offset % size_ != 0) {
+	  return totalCount_;
 	}
-	totalCount_ = volume;
-	size_ = size;
-	count_ = 0;
-	index_ = 0;
-	pool_ = std::make_unique<PoolVec_t>();
-	chunkHead_ = calloc(volume + GUARD_BYTES_COUNT, size);
-	if (chunkHead_ == nullptr) {
-	  std::cerr << __func__ << " [ERROR] chunkHead_ == nullptr" << std::endl;
+	return offset / size_;
+  }
+
+  [[nodiscard]] bool isFull() const { return count_ >= totalCount_; }
+
+  [[nodiscard]] bool isInUse(size_t index) const {
+	return (inUse_[index / bitmapWordBits_] >> (index % bitmapWordBits_)) & 1;
+  }
+
+  /// @brief Take the lowest returned slot, or else the next untouched one
+  /// @returns the slot or nullptr if the slab is full
+  void *acquire() {
+	size_t index;
+	if (count_ < index_) {
+	  index = findFree();
+	} else if (index_ < totalCount_ && (index_ < prepared_ || prepare(1))) {
+	  index = index_++;
+	} else {
+	  return nullptr;
 	}
-	int i = 0;
-	for (; i < totalCount_; i++) {
-	  pool_->emplace_back(std::make_unique<PoolNode_t>(false, ((uint8_t *)chunkHead_ + (size * i))));
+	markInUse(index);
+	++count_;
+	return slot(index);
+  }
+
+  /// @brief Take up to `count` slots: returned ones a bitmap word at a time, then one contiguous run of untouched slots
+  /// @returns number of slot addresses written to `out`
+  size_t acquireBatch(void **out, size_t count) {
+	size_t got = 0;
+	while (got < count && count_ < index_) {
+	  const auto word = findFree() / bitmapWordBits_;
+	  const auto first = word * bitmapWordBits_;
+	  auto free = ~inUse_[word];
+	  if (index_ - first < bitmapWordBits_) {
+		free &= (1ULL << (index_ - first)) - 1;// Untouched slots go through the run below
+	  }
+	  for (; free != 0 && got < count; free &= (free - 1)) {
+		const auto bit = (size_t)__builtin_ctzll(free);
+		markInUse(first + bit);
+		out[got++] = slot(first + bit);
+		++count_;
+	  }
 	}
-	guard_ = ((uint8_t *)chunkHead_ + (size * i));
+	auto run = std::min(count - got, totalCount_ - index_);
+	if (index_ + run > prepared_ && !prepare(run)) {
+	  run = prepared_ - index_;
+	}
+	for (size_t i = index_; i < index_ + run; ++i) {
+	  markInUse(i);
+	  out[got++] = slot(i);
+	}
+	index_ += run;
+	count_ += run;
+	return got;
   }
 
+  /// @brief Hand the slot at `index` back in O(1)
+  /// @returns false if the slot was not in use (double free)
+  bool release(size_t index) {
+	const auto word = index / bitmapWordBits_;
+	const auto mask = 1ULL << (index % bitmapWordBits_);
+	if ((inUse_[word] & mask) == 0) {
+	  return false;
+	}
+	inUse_[word] &= ~mask;
+	full_[word / bitmapWordBits_] &= ~(1ULL << (word % bitmapWordBits_));
+	hint_ = std::min(hint_, word);
+	--count_;
+	return true;
+  }
+
+  /// @brief An empty slab that has touched enough pages since its last purge to be worth handing them back
+  [[nodiscard]] bool isPurgeable() const {
+	return (backing_ == SlabBacking::RESERVED || backing_ == SlabBacking::HUGE_TRANSPARENT) && count_ == 0
+		&& (index_ * size_) >= purgeMinBytes_;
+  }
+
+  /// @brief Give the pages of an empty slab back to the OS and start over from its first slot
+  void purge();
+
+  [[nodiscard]] bool validateSlab() const;
+
+ private:
+  /// @brief Map the slab with `backing`, falling back to the next weaker backing on failure
+  void map(size_t bytes, SlabBacking backing);
+
+  /// @brief Prefer node_ for the pages of this slab; HEAP slabs only bind the pages they own entirely
+  void bindNode();
+
+  /// @brief Commit pages for at least `count` slots past index_
+  /// @returns false if the pages could not be committed
+  bool prepare(size_t count);
+
+  void markInUse(size_t index) {
+	auto &word = inUse_[index / bitmapWordBits_];
+	word |= (1ULL << (index % bitmapWordBits_));
+	if (word == ~0ULL) {
+	  const auto w = index / bitmapWordBits_;
+	  full_[w / bitmapWordBits_] |= (1ULL << (w % bitmapWordBits_));
+	}
+  }
+
+  /// @brief Lowest free slot below index_; only valid while count_ < index_
+  size_t findFree() {
+	auto summary = hint_ / bitmapWordBits_;
+	while (full_[summary] == ~0ULL) {
+	  ++summary;
+	}
+	hint_ = std::max(hint_, (summary * bitmapWordBits_) + __builtin_ctzll(~full_[summary]));
+	return (hint_ * bitmapWordBits_) + __builtin_ctzll(~inUse_[hint_]);
+  }
+} Slab_t;
+
+using SlabPtr_t = std::unique_ptr<Slab_t>;
+using SlabVec_t = std::vector<SlabPtr_t>;
+
+/// @note The counters are written by the owner thread only and can be read from any thread
+typedef struct ObjectPool {
+  base::Counter<size_t> totalCount_;// Total Number of Objects Available across all slabs
+  size_t size_;                     // Object Size, i.e. slot stride
+  size_t align_;                    // Slot alignment
+  base::Counter<size_t> count_;     // Number of Objects in Use
+  base::Counter<size_t> highWater_; // Most Objects ever in Use at once
+  base::Counter<uint64_t> allocCount_;
+  base::Counter<uint64_t> freeCount_;
+  base::Counter<uint64_t> overflowCount_;// calloc'ed blocks handed out because every slab was full
+  size_t maxCount_;                      // Growth cap
+  PoolConfig_t config_;
+  SlabVec_t slabs_;// slabs_[0] is the initial slab and is never released
+  Slab_t *active_; // Slab we allocate from until it runs full
+  LockLessQ<PointerNode> reclaimed_;// Slots settled by the reclaimer thread; still marked in use until handed out again
+
+  [[nodiscard]] std::string str() const;
+
+  /// @brief Backings the slabs of this pool actually got, e.g. "thp" or "hugetlb+thp"
+  [[nodiscard]] std::string backings() const;
+
+  /// @brief NUMA nodes the slabs of this pool are bound to, e.g. "0" or "0+1"; "any" if unbound
+  [[nodiscard]] std::string nodes() const;
+
+  /// @brief Snapshot of the counters of this pool
+  /// @param id: registered ID to report, -1 for a size class pool
+  [[nodiscard]] PoolStats_t snapshot(int id) const;
+
+  /// @param align: power of two up to the page size; the slot stride is `size` rounded up to it. Raised to
+  ///               cacheLineBytes_ for a padded pool, and to what the inbox node needs
+  explicit ObjectPool(size_t volume, size_t size, size_t align = defaultSlotAlign_,
+					  const PoolConfig_t &config = {{GrowthPolicy_t::NONE, 0, 0}, SlabBacking::HEAP});
+
   ObjectPool() = delete;
 
-  ~ObjectPool() {
-	if (chunkHead_) {
-	  free(chunkHead_);
-	  chunkHead_ = nullptr;
+  ~ObjectPool() = default;
+
+  /// @brief Take a free slot, from the active slab if possible
+  /// @returns the slot or nullptr if every slab is full
+  void *acquire() {
+	auto ptr = active_->acquire();
+	if (ptr == nullptr) {
+	  ptr = acquireSlow();
+	}
+	if (ptr != nullptr) {
+	  acquired(1);
 	}
+	return ptr;
   }
 
-  [[nodiscard]] bool validatePool() const {
-	if (memcmp(guard_, gTestGuard, GUARD_BYTES_COUNT) != 0) {
-	  std::cerr << __func__ << " Memory Corruption Detected (Overflow). Re-run with ASan recommended!"
-				<< std::endl;
+  /// @brief Take a slot the reclaimer thread has settled, if any
+  /// @note Owner thread only; the slot is still marked in use, so only the counters change. Its first bytes still hold
+  ///       the queue node until prepare(ptr, true)
+  void *reuse() {
+	const auto node = reclaimed_.dequeue();
+	if (node == nullptr) {
+	  return nullptr;
+	}
+	++freeCount_;
+	++allocCount_;
+	return node->ptr_;
+  }
+
+  /// @brief Reclaimer thread only: reset a slot returned by another thread and queue it for reuse by the owner
+  void reclaim(void *ptr) {
+	zeroOnFree(ptr);
+	reclaimed_.enqueue(new (ptr) PointerNode(ptr));
+  }
+
+  /// @brief Owner thread only: give a slot taken from reclaimed_ back to its slab, without zeroing it again
+  /// @returns false if the slot was not in use
+  bool restore(Slab_t *slab, size_t index) {
+	if (!slab->release(index)) {
 	  return false;
 	}
+	if (config_.zero_ == ZeroPolicy::ON_FREE || config_.zero_ == ZeroPolicy::ON_FREE_NT) {
+	  memset(slab->slot(index), 0, sizeof(PointerNode));// The reclaimer zeroed the rest
+	}
+	--count_;
 	return true;
   }
-} ObjectPool_t;
 
-struct PointerNode {
-  void *ptr_;
-  std::atomic<PointerNode *> next_;
+  /// @brief Slots handed out and not returned yet; those waiting in reclaimed_ are counted in count_ but are free
+  /// @note Approximate while the reclaimer is at work
+  [[nodiscard]] size_t inUse() const {
+	const size_t count = count_;
+	return count - std::min(count, reclaimed_.approx_size());
+  }
 
-  explicit PointerNode(void *ptr) : ptr_(ptr), next_(nullptr) {}
+  /// @brief Zero a slot about to be handed out, as far as the zero policy leaves it dirty
+  /// @param reused: the slot comes from reuse(), so the queue node is still in it
+  void prepare(void *ptr, bool reused) const {
+	if (config_.zero_ == ZeroPolicy::ON_ALLOC) {
+	  memset(ptr, 0, size_);
+	} else if (reused && config_.zero_ != ZeroPolicy::NONE) {
+	  memset(ptr, 0, sizeof(PointerNode));// Freeing zeroed the rest
+	}
+  }
 
-  PointerNode() = delete;
-};
+  /// @brief Take up to `count` slots from the slabs that still have room
+  /// @returns number of slot addresses written to `out`
+  size_t acquireBatch(void **out, size_t count);
+
+  /// @brief Hand the slot at `index` of `slab` back
+  /// @returns false if the slot was not in use (double free)
+  bool release(Slab_t *slab, size_t index) {
+	if (!slab->release(index)) {
+	  return false;
+	}
+	zeroOnFree(slab->slot(index));
+	--count_;
+	++freeCount_;
+	return true;
+  }
+
+  [[nodiscard]] bool canGrow() const { return config_.growth_.mode_ != GrowthPolicy_t::NONE && totalCount_ < maxCount_; }
+
+  /// @brief Add a slab according to the growth policy
+  /// @returns the new slab or nullptr if the policy or the cap forbids it
+  Slab_t *grow();
+
+  /// @brief A grown slab can go once it is empty and the rest of the pool stays below the lower threshold
+  [[nodiscard]] bool isReleasable(const Slab_t *slab, double threshold) const {
+	return slab != slabs_.front().get() && slab->count_ == 0
+		&& count_ <= ((totalCount_ - slab->totalCount_) * threshold);
+  }
+
+  /// @brief Free `slab` and give its memory back
+  void releaseSlab(const Slab_t *slab);
+
+  /// @brief Take `slab` out of the pool without freeing it, e.g. so it can outlive the pool
+  /// @note Detaching the initial slab leaves a pool that can only be destroyed
+  /// @returns the slab or nullptr if it is not part of this pool
+  SlabPtr_t detachSlab(const Slab_t *slab);
+
+  [[nodiscard]] bool validatePool() const;
+
+ private:
+  void *acquireSlow();
+
+  void zeroOnFree(void *ptr) const {
+	if (config_.zero_ == ZeroPolicy::ON_FREE) {
+	  memset(ptr, 0, size_);
+	} else if (config_.zero_ == ZeroPolicy::ON_FREE_NT) {
+	  streamZero(ptr, size_);
+	}
+  }
+
+  /// @brief memset with non-temporal stores, fenced so the zeroes are visible before the slot is handed on
+  static void streamZero(void *ptr, size_t size);
+
+  void acquired(size_t count) {
+	count_ += count;
+	allocCount_ += count;
+	if (count_ > highWater_) {
+	  highWater_ = count_;
+	}
+  }
+
+  /// @brief Node a new slab goes to under the pool configuration
+  [[nodiscard]] int slabNode() const;
+} ObjectPool_t;
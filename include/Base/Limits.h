@@ -4,3 +4,24 @@ constexpr auto defaultVolume_ = 100000;       // 0.1Million Objects
 constexpr auto upperThreshold_ = 0.95;        // 95%
 constexpr auto lowerThreshold_ = 0.60;        // 60%
 constexpr auto threadOccupancyThreshold_ = 88;// 88%
+constexpr auto occupancySampleNs_ = 1000000;  // Thread CPU time is sampled at most once per 1ms
+constexpr auto occupancyWindowSlots_ = 16;    // Occupancy is averaged over the last 16 samples
+constexpr auto houseKeepingSlice_ = 4096;     // Inbox entries settled per housekeeping run, by default; few runs, so p999 holds
+constexpr auto houseKeepingBudgetUs_ = 200;   // Time per housekeeping run, by default; above what the slice takes
+constexpr auto houseKeepingClockStride_ = 32; // Inbox entries settled between two reads of the clock
+constexpr auto houseKeepingDeferStride_ = 64; // Calls between two reads of the clock while housekeeping is deferred
+constexpr auto reclaimerBatch_ = 256;         // Inbox entries the reclaimer thread takes from one MemPool at a time
+constexpr auto reclaimerIdleUs_ = 100;        // Reclaimer sleep once every inbox is empty, by default
+constexpr auto reclaimedBacklog_ = 1024;      // Slots waiting in a reclaimed queue before the owner gives them back
+constexpr auto reclaimerNice_ = 19;           // Reclaimer runs at the lowest priority
+constexpr auto lockMaxPauses_ = 1024;         // Longest backoff of a spinning waiter, in pause instructions
+constexpr auto lockYieldRounds_ = 16;         // Yields of a waiter after spinning and before it sleeps on the futex
+constexpr auto lockTicketPauses_ = 64;        // Ticket lock backoff per waiter ahead of us, in pause instructions
+constexpr auto lockTicketSpinQueue_ = 8;      // Ticket lock waiters further back than this yield instead of spinning
+constexpr auto cacheLineBytes_ = 64;          // Stride of padded slots, so that no two objects share a cache line
+constexpr auto epochReaderStripes_ = 8;       // Cache lines the readers of an epoch count themselves on
+constexpr auto sizeClassChunkBytes_ = 1024 * 1024;// 1MiB of slots per size class pool
+constexpr auto sizeClassMinVolume_ = 32;          // Objects per size class pool, at least
+constexpr auto maxGrowthFactor_ = 16;             // Default cap of a growable pool, in multiples of its initial volume
+constexpr auto commitStepBytes_ = 64 * 1024;      // RESERVED slabs commit pages in steps of at least this much
+constexpr auto purgeMinBytes_ = 256 * 1024;       // Empty RESERVED slabs hand pages back only above this much
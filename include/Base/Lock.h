@@ -1,10 +1,39 @@
 #pragma once
 
+#include "Limits.h"
+#include "Stats.h"
 #include <atomic>
+#include <climits>
+#include <linux/futex.h>
 #include <string>
+#include <sys/syscall.h>
 #include <thread>
+#include <unistd.h>
 #include <utility>
 
+namespace base {
+  /// @brief Tell the CPU we are spinning, so the sibling hyper-thread gets the pipeline
+  __always_inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield" ::: "memory");
+#endif
+  }
+
+  /// @brief Sleep until woken, unless `word` no longer holds `expected`
+  inline void futexWait(std::atomic<uint32_t> &word, uint32_t expected) {
+	syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+  }
+
+  /// @brief Wake up to `count` threads sleeping on `word`
+  inline void futexWake(std::atomic<uint32_t> &word, int count) {
+	syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+  }
+}// namespace base
+
+/// @brief Adaptive lock: spins with exponential pause backoff, then yields, then sleeps on a futex
+/// @note Spinning is skipped on a single CPU, where the holder can't make progress while we spin
 class SpinLock {
  public:
   SpinLock(SpinLock &) = delete;
@@ -15,39 +44,209 @@ class SpinLock {
   }
 
   explicit SpinLock(std::string name)
-	  : name_(std::move(name)), lock_(ATOMIC_FLAG_INIT), exhaust_limit_(get_exhaust_limit()) {
+	  : name_(std::move(name)), state_(UNLOCKED), spin_(std::thread::hardware_concurrency() > 1) {
+  }
+
+  __always_inline bool trylock() {
+	if (!acquire()) {
+	  return false;
+	}
+	++acquireCount_;
+	return true;
+  }
+
+  /// @note Never gives up; a lock that can't be had is a deadlock, not something to carry on from
+  __always_inline void lock() {
+	if (!trylock()) {
+	  lock_slow();
+	}
+  }
+
+  __always_inline void unlock() {
+	if (state_.exchange(UNLOCKED, std::memory_order_release) == SLEEPERS) {
+	  base::futexWake(state_, 1);
+	}
+  }
+
+  [[nodiscard]] const std::string &get_name() const {
+	return name_;
+  }
+
+  /// @note Safe to call without the lock; counters are read individually
+  [[nodiscard]] LockStats_t get_stats() const {
+	return {acquireCount_, contendedCount_, spinCount_, yieldCount_, sleepCount_};
+  }
+
+ private:
+  enum : uint32_t { UNLOCKED, LOCKED, SLEEPERS };
+
+  __always_inline bool acquire() {
+	uint32_t expected = UNLOCKED;
+	return state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  void lock_slow() {
+	uint64_t spins = 0, yields = 0, sleeps = 0;
+	bool acquired = false;
+	for (uint32_t pauses = 1; spin_ && !acquired && pauses <= lockMaxPauses_; pauses <<= 1) {
+	  for (uint32_t i = 0; i < pauses; ++i) {
+		base::cpuRelax();
+	  }
+	  ++spins;
+	  acquired = (state_.load(std::memory_order_relaxed) == UNLOCKED) && acquire();
+	}
+	for (auto i = 0; !acquired && i < lockYieldRounds_; ++i) {
+	  std::this_thread::yield();
+	  ++yields;
+	  acquired = (state_.load(std::memory_order_relaxed) == UNLOCKED) && acquire();
+	}
+	if (!acquired) {
+	  // Taken as SLEEPERS even if nobody else sleeps; the worst that does is a spurious wake
+	  while (state_.exchange(SLEEPERS, std::memory_order_acquire) != UNLOCKED) {
+		++sleeps;
+		base::futexWait(state_, SLEEPERS);
+	  }
+	}
+	// We hold the lock, so nobody else writes the counters
+	++acquireCount_;
+	++contendedCount_;
+	spinCount_ += spins;
+	yieldCount_ += yields;
+	sleepCount_ += sleeps;
+  }
+
+  std::string name_;
+  std::atomic<uint32_t> state_;
+  const bool spin_;
+  base::Counter<uint64_t> acquireCount_;
+  base::Counter<uint64_t> contendedCount_;
+  base::Counter<uint64_t> spinCount_;
+  base::Counter<uint64_t> yieldCount_;
+  base::Counter<uint64_t> sleepCount_;
+};
+
+/// @brief FIFO lock: waiters are served in arrival order, backing off in proportion to the queue ahead of them
+/// @note Fair under heavy contention, at the price of a hand-off that stalls whenever the next waiter is descheduled
+class TicketLock {
+ public:
+  TicketLock(TicketLock &) = delete;
+  TicketLock(TicketLock &&) = delete;
+  ~TicketLock() = default;
+
+  TicketLock() : TicketLock("TicketLock") {
   }
 
-  static uint64_t get_exhaust_limit() {
-	return std::thread::hardware_concurrency() * 100000;
+  explicit TicketLock(std::string name)
+	  : name_(std::move(name)), next_(0), serving_(0), spin_(std::thread::hardware_concurrency() > 1) {
   }
 
   __always_inline bool trylock() {
-	return lock_.test_and_set(std::memory_order_acquire);
+	auto ticket = serving_.load(std::memory_order_acquire);
+	if (!next_.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+	  return false;
+	}
+	++acquireCount_;
+	return true;
   }
 
-  bool lock() {
-	int count = 0;
-	clock_t start = clock();
-	while (((clock() - start) / CLOCKS_PER_SEC <= 10) || count < exhaust_limit_) {
-	  if (trylock()) {
-		return true;
+  void lock() {
+	const auto ticket = next_.fetch_add(1, std::memory_order_relaxed);
+	uint64_t spins = 0, yields = 0;
+	uint32_t serving;
+	while ((serving = serving_.load(std::memory_order_acquire)) != ticket) {
+	  const auto ahead = ticket - serving;
+	  if (spin_ && ahead <= lockTicketSpinQueue_) {
+		for (uint32_t i = 0; i < ahead * lockTicketPauses_; ++i) {
+		  base::cpuRelax();
+		}
+		++spins;
+	  } else {
+		std::this_thread::yield();
+		++yields;
 	  }
-	  ++count;
 	}
-	return false;
+	++acquireCount_;
+	if (spins + yields != 0) {
+	  ++contendedCount_;
+	  spinCount_ += spins;
+	  yieldCount_ += yields;
+	}
   }
 
-  void unlock() {
-	lock_.clear(std::memory_order_release);
+  __always_inline void unlock() {
+	serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
   }
 
   [[nodiscard]] const std::string &get_name() const {
 	return name_;
   }
 
+  /// @note Safe to call without the lock; counters are read individually
+  [[nodiscard]] LockStats_t get_stats() const {
+	return {acquireCount_, contendedCount_, spinCount_, yieldCount_, 0};
+  }
+
  private:
-  std::atomic_flag lock_;
   std::string name_;
-  const uint64_t exhaust_limit_;
+  std::atomic<uint32_t> next_;   // Next ticket to hand out
+  std::atomic<uint32_t> serving_;// Ticket holding the lock
+  const bool spin_;
+  base::Counter<uint64_t> acquireCount_;
+  base::Counter<uint64_t> contendedCount_;
+  base::Counter<uint64_t> spinCount_;
+  base::Counter<uint64_t> yieldCount_;
+};
+
+/// @brief Read-mostly publication: readers never wait, a writer waits out the readers that may still see what it replaced
+/// @note Readers count themselves on one of two sides that flip with every synchronize(), striped over cache lines
+class ReadEpoch {
+ public:
+  ReadEpoch(ReadEpoch &) = delete;
+  ReadEpoch(ReadEpoch &&) = delete;
+  ReadEpoch() = default;
+  ~ReadEpoch() = default;
+
+  /// @returns the ticket to hand back to leave()
+  __always_inline size_t enter() {
+	const auto stripe = readerStripe();
+	while (true) {
+	  const auto epoch = epoch_.load(std::memory_order_seq_cst);
+	  auto &readers = readers_[epoch & 1][stripe].count_;
+	  readers.fetch_add(1, std::memory_order_seq_cst);
+	  if (epoch_.load(std::memory_order_seq_cst) == epoch) {
+		return (epoch & 1) * epochReaderStripes_ + stripe;
+	  }
+	  readers.fetch_sub(1, std::memory_order_release);// A writer flipped in between and may not have counted us
+	}
+  }
+
+  __always_inline void leave(size_t _ticket) {
+	auto &readers = readers_[_ticket / epochReaderStripes_][_ticket % epochReaderStripes_].count_;
+	readers.fetch_sub(1, std::memory_order_release);
+  }
+
+  /// @brief Wait until every reader that entered before the call has left
+  /// @note Writers must be serialized by the caller, and must not be readers themselves
+  void synchronize() {
+	const auto side = epoch_.fetch_add(1, std::memory_order_seq_cst) & 1;
+	for (auto &stripe : readers_[side]) {
+	  while (stripe.count_.load(std::memory_order_seq_cst) != 0) {
+		std::this_thread::yield();
+	  }
+	}
+  }
+
+ private:
+  typedef struct alignas(cacheLineBytes_) Stripe {
+	std::atomic<uint32_t> count_ {0};
+  } Stripe_t;
+
+  static size_t readerStripe() {
+	static std::atomic<size_t> next {0};
+	thread_local const size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % epochReaderStripes_;
+	return stripe;
+  }
+
+  std::atomic<uint64_t> epoch_ {0};
+  Stripe_t readers_[2][epochReaderStripes_];
 };
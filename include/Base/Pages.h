@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+namespace base {
+  /// @brief Size of a regular page
+  size_t pageSize();
+
+  /// @brief Size of a huge page (Hugepagesize in /proc/meminfo, 2MiB if unknown)
+  size_t hugePageSize();
+
+  /// @brief Whether the kernel builds transparent huge pages for regions advised with MADV_HUGEPAGE
+  bool transparentHugePagesEnabled();
+
+  /// @brief Round `bytes` up to a multiple of `granule` (a power of two)
+  constexpr size_t roundUp(size_t bytes, size_t granule) { return (bytes + granule - 1) & ~(granule - 1); }
+
+  /// @brief Reserve address space without committing any memory
+  /// @returns start of the reservation or nullptr on failure
+  void *reservePages(size_t bytes);
+
+  /// @brief Reserve address space starting at a multiple of `alignment` (a multiple of the page size)
+  /// @returns start of the reservation or nullptr on failure
+  void *reserveAlignedPages(size_t bytes, size_t alignment);
+
+  /// @brief Map `bytes` (a multiple of hugePageSize()) read-write from the hugetlbfs pool
+  /// @returns start of the mapping or nullptr if no huge pages are available
+  void *mapHugeTlbPages(size_t bytes);
+
+  /// @brief Ask for transparent huge pages behind `addr`
+  /// @returns true if the kernel accepted the advice
+  bool adviseHugePages(void *addr, size_t bytes);
+
+  /// @brief Make reserved pages readable and writable; they are zero-filled and backed on first touch
+  /// @returns true on success
+  bool commitPages(void *addr, size_t bytes);
+
+  /// @brief Hand the physical pages behind `addr` back to the OS while keeping them mapped
+  /// @note Uses MADV_DONTNEED so RSS drops right away; build with MEMPOOL_MADV_FREE for the lazier MADV_FREE
+  void purgePages(void *addr, size_t bytes);
+
+  /// @brief Number of online NUMA nodes (1 when the system has no NUMA topology)
+  size_t numaNodeCount();
+
+  /// @brief NUMA node of the CPU the calling thread runs on
+  int currentNumaNode();
+
+  /// @brief Prefer `node` for the pages behind `addr`, moving the ones already touched
+  /// @note No-op on single-node systems
+  /// @returns true on success
+  bool bindPagesToNode(void *addr, size_t bytes, int node);
+
+  /// @brief Release a reservation or mapping made by one of the functions above
+  void unmapPages(void *addr, size_t bytes);
+}// namespace base
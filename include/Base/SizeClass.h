@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Size classes: 16 byte steps up to 128 bytes, then four classes per power of two up to 32KiB
+// 16, 32, ... 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, ... 28672, 32768
+constexpr size_t sizeClassSmallStep_ = 16;
+constexpr size_t sizeClassSmallMax_ = 128;
+constexpr size_t sizeClassSmallCount_ = sizeClassSmallMax_ / sizeClassSmallStep_;
+constexpr size_t sizeClassStepsPerPow2_ = 4;
+constexpr size_t sizeClassMax_ = 32 * 1024;
+constexpr size_t sizeClassCount_ = sizeClassSmallCount_ + (sizeClassStepsPerPow2_ * 8);// 128 -> 32KiB is 8 doublings
+
+/// @brief Map a requested size to its size class index
+/// @returns index in [0, sizeClassCount_) or sizeClassCount_ if `size` is larger than sizeClassMax_
+constexpr size_t sizeClassIndex(size_t size) {
+  if (size <= sizeClassSmallMax_) {
+	return (size == 0) ? 0 : ((size + sizeClassSmallStep_ - 1) / sizeClassSmallStep_) - 1;
+  }
+  if (size > sizeClassMax_) {
+	return sizeClassCount_;
+  }
+  const size_t pow2 = 63 - __builtin_clzll(size - 1);// size is in (2^pow2, 2^(pow2 + 1)]
+  const size_t base = (size_t)1 << pow2;
+  const size_t step = base / sizeClassStepsPerPow2_;
+  return sizeClassSmallCount_ + ((pow2 - 7) * sizeClassStepsPerPow2_) + ((size - base + step - 1) / step) - 1;
+}
+
+/// @brief Slot size of the size class at `index`
+constexpr size_t sizeClassSize(size_t index) {
+  if (index < sizeClassSmallCount_) {
+	return (index + 1) * sizeClassSmallStep_;
+  }
+  const size_t k = index - sizeClassSmallCount_;
+  const size_t base = (size_t)sizeClassSmallMax_ << (k / sizeClassStepsPerPow2_);
+  return base + ((k % sizeClassStepsPerPow2_) + 1) * (base / sizeClassStepsPerPow2_);
+}
+
+static_assert(sizeClassSize(sizeClassIndex(1)) == 16);
+static_assert(sizeClassSize(sizeClassIndex(129)) == 160);
+static_assert(sizeClassSize(sizeClassIndex(256)) == 256);
+static_assert(sizeClassSize(sizeClassIndex(257)) == 320);
+static_assert(sizeClassSize(sizeClassCount_ - 1) == sizeClassMax_);
+static_assert(sizeClassIndex(sizeClassMax_ + 1) == sizeClassCount_);
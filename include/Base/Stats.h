@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+namespace base {
+  /// @brief Counter written by its owner thread only and readable from any thread without a lock
+  /// @note Updates are a relaxed load and store, i.e. plain moves on x86; never update it from two threads
+  template<typename T>
+  class Counter {
+   public:
+	Counter(T value = 0) : value_(value) {}
+
+	Counter(const Counter &other) : value_(T(other)) {}
+
+	Counter &operator=(const Counter &other) { return *this = T(other); }
+
+	operator T() const { return value_.load(std::memory_order_relaxed); }
+
+	Counter &operator=(T value) {
+	  value_.store(value, std::memory_order_relaxed);
+	  return *this;
+	}
+
+	Counter &operator+=(T delta) { return *this = (T(*this) + delta); }
+
+	Counter &operator-=(T delta) { return *this = (T(*this) - delta); }
+
+	Counter &operator++() { return *this += 1; }
+
+	Counter &operator--() { return *this -= 1; }
+
+	T operator++(int) {
+	  const T old = *this;
+	  *this += 1;
+	  return old;
+	}
+
+   private:
+	std::atomic<T> value_;
+  };
+}// namespace base
+
+// HDR-style log-linear buckets: exact below 16ns, then 8 sub-buckets per power of two (< 12.5% error) up to 2^40ns
+constexpr size_t latencyExactBuckets_ = 16;
+constexpr size_t latencySubBucketBits_ = 3;
+constexpr size_t latencyMaxPow2_ = 40;
+constexpr size_t latencyBucketCount_ = latencyExactBuckets_ + ((latencyMaxPow2_ - 4) << latencySubBucketBits_);
+
+/// @brief Snapshot of a latency histogram
+typedef struct LatencyHistogram {
+  uint64_t buckets_[latencyBucketCount_];
+
+  static constexpr size_t bucketOf(uint64_t ns) {
+	if (ns < latencyExactBuckets_) {
+	  return ns;
+	}
+	const size_t pow2 = 63 - __builtin_clzll(ns);
+	if (pow2 >= latencyMaxPow2_) {
+	  return latencyBucketCount_ - 1;
+	}
+	const size_t sub = (ns >> (pow2 - latencySubBucketBits_)) & ((1 << latencySubBucketBits_) - 1);
+	return latencyExactBuckets_ + ((pow2 - 4) << latencySubBucketBits_) + sub;
+  }
+
+  /// @brief Smallest latency that lands in `bucket`
+  static constexpr uint64_t lowerBound(size_t bucket) {
+	if (bucket < latencyExactBuckets_) {
+	  return bucket;
+	}
+	const size_t pow2 = ((bucket - latencyExactBuckets_) >> latencySubBucketBits_) + 4;
+	const size_t sub = (bucket - latencyExactBuckets_) & ((1 << latencySubBucketBits_) - 1);
+	return (uint64_t)((1 << latencySubBucketBits_) + sub) << (pow2 - latencySubBucketBits_);
+  }
+
+  [[nodiscard]] uint64_t count() const {
+	uint64_t total = 0;
+	for (auto samples : buckets_) {
+	  total += samples;
+	}
+	return total;
+  }
+
+  /// @param pct: in [0, 1]
+  /// @returns lower bound of the bucket holding the `pct` quantile, 0 if empty
+  [[nodiscard]] uint64_t percentile(double pct) const {
+	const auto rank = (uint64_t)(pct * count());
+	uint64_t seen = 0;
+	for (size_t i = 0; i < latencyBucketCount_; ++i) {
+	  seen += buckets_[i];
+	  if (seen > rank) {
+		return lowerBound(i);
+	  }
+	}
+	return 0;
+  }
+} LatencyHistogram_t;
+
+static_assert(LatencyHistogram_t::bucketOf(15) == 15 && LatencyHistogram_t::bucketOf(16) == 16);
+static_assert(LatencyHistogram_t::lowerBound(LatencyHistogram_t::bucketOf(1000)) <= 1000);
+static_assert(LatencyHistogram_t::lowerBound(LatencyHistogram_t::bucketOf(1000) + 1) > 1000);
+
+/// @brief Live histogram, recorded by its owner thread and snapshotted by anyone
+class LatencyRecorder {
+ public:
+  void record(uint64_t ns) { ++buckets_[LatencyHistogram_t::bucketOf(ns)]; }
+
+  void snapshot(LatencyHistogram_t &out) const {
+	for (size_t i = 0; i < latencyBucketCount_; ++i) {
+	  out.buckets_[i] = buckets_[i];
+	}
+  }
+
+ private:
+  base::Counter<uint64_t> buckets_[latencyBucketCount_];
+};
+
+/// @brief Records the lifetime of the scope into a recorder, if any
+class LatencyTimer {
+ public:
+  explicit LatencyTimer(LatencyRecorder *recorder)
+	  : recorder_(recorder), start_(std::chrono::steady_clock::now()) {}
+
+  ~LatencyTimer() {
+	if (recorder_ != nullptr) {
+	  recorder_->record(
+		  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+	}
+  }
+
+ private:
+  LatencyRecorder *recorder_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/// @brief Snapshot of the contention counters of a lock
+typedef struct LockStats {
+  uint64_t acquireCount_;
+  uint64_t contendedCount_;// Acquisitions that found the lock held
+  uint64_t spinCount_;     // Backoff rounds of the waiters
+  uint64_t yieldCount_;
+  uint64_t sleepCount_;    // Futex waits
+} LockStats_t;
+
+/// @brief Snapshot of one pool
+typedef struct PoolStats {
+  int id_;              // Registered ID; -1 for a size class pool
+  size_t objectSize_;   // Slot size
+  size_t capacity_;     // Slots across all slabs
+  size_t inUse_;        // Slots dispatched and not yet returned to the owner
+  size_t highWater_;    // Most slots ever in use at once
+  size_t slabCount_;    // Slabs, the initial one included
+  uint64_t allocCount_; // Slots dispatched
+  uint64_t freeCount_;  // Slots returned, locally or through the inbox
+  uint64_t overflowCount_;// calloc'ed blocks handed out because the pool was exhausted
+} PoolStats_t;
+
+/// @brief Pools of one type ID (or size class) summed over every live MemPool
+typedef struct TypeStats {
+  int id_;              // Registered ID; -1 for a size class
+  size_t objectSize_;   // Slot size
+  size_t threadCount_;  // MemPools with a pool for this type
+  size_t capacity_;
+  size_t inUse_;
+  size_t highWater_;    // Sum of the per-thread high-water marks
+  uint64_t allocCount_;
+  uint64_t freeCount_;
+  uint64_t overflowCount_;
+} TypeStats_t;
+
+/// @brief Snapshot of the counters of one thread's MemPool
+typedef struct ThreadStats {
+  pthread_t tid_;
+  size_t poolCount_;                   // Registered IDs
+  uint64_t getBufCount_;               // Buffers handed out, overflow blocks included
+  uint64_t retBufCount_;               // Buffers returned on this thread into its own pools
+  uint64_t overflowAllocCount_;        // calloc'ed overflow blocks handed out
+  uint64_t overflowFreeCount_;         // Overflow blocks freed on this thread
+  uint64_t houseKeepingCount_;
+  uint64_t houseKeepingDeferCount_;    // Housekeeping put off because the thread was busy; once per occupancy sample
+  uint64_t mandatoryHouseKeepingCount_;// Housekeeping forced at the upper threshold
+  uint64_t houseKeepingNs_;            // Time spent in housekeeping
+  uint64_t slabGrowCount_;
+  uint64_t slabReleaseCount_;
+  uint64_t slabPurgeCount_;
+  size_t pendingRemoteReturns_;        // Frees by other threads waiting in the inbox
+  uint64_t reclaimedCount_;            // Frees by other threads settled by the reclaimer thread
+  unsigned occupancy_;                 // CPU occupancy % of the thread at its last housekeeping decision
+#if MEMPOOL_LATENCY_HISTOGRAM
+  LatencyHistogram_t getLatency_;   // getBuffer/allocate on this thread
+  LatencyHistogram_t returnLatency_;// returnBuffer/deallocate on this thread
+#endif
+} ThreadStats_t;
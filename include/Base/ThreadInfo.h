@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Limits.h"
+#include <cstdint>
 #include <memory>
 #include <mutex>
 
@@ -24,7 +26,13 @@ namespace base {
 
 	[[maybe_unused]] uint64_t getUserTimeSinceLast();
 
-	static uint getOccupancy();
+	/// @brief CPU time (user + system) consumed by the calling thread, in nanoseconds
+	static uint64_t getCpuTime();
+
+	/// @brief Share of wall time this thread spent on a CPU over a sliding window of recent samples
+	/// @note Samples CLOCK_THREAD_CPUTIME_ID at most once per occupancySampleNs_; calls in between are a clock read
+	/// @returns percentage in [0, 100]
+	uint getOccupancy();
 
 	[[nodiscard]] pthread_t getTid() const {
 	  return tid_;
@@ -33,8 +41,17 @@ namespace base {
    private:
 	ThreadInfo();
 
+	typedef struct OccupancySample {
+	  uint64_t wallNs_;
+	  uint64_t cpuNs_;
+	} OccupancySample_t;
+
    private:
 	static thread_local ThreadInfoPtr_t instance_;
+	OccupancySample_t samples_[occupancyWindowSlots_];// Ring of the most recent samples
+	size_t nextSample_;
+	size_t sampleCount_;
+	uint occupancy_;// As of the newest sample
 	uint64_t lastSysTime_;
 	uint64_t lastUsrTime_;
 	std::string name_;
@@ -3,10 +3,12 @@
 #include "Base/Constructs.h"
 #include "Base/Limits.h"
 #include "Base/Lock.h"
+#include "Base/SizeClass.h"
 #include "util/LockLessQ.h"
 #include <algorithm>
 #include <atomic>
-#include <list>
+#include <csignal>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <thread>
@@ -19,34 +21,116 @@ using MemPoolPtr_t = std::shared_ptr<MemPool>;
 using ObjectPoolPtr_t = std::shared_ptr<ObjectPool_t>;
 using ObjectMap_t = std::unordered_map<uint64_t, ObjectPoolPtr_t>;
 using ObjectMapPtr_t = std::shared_ptr<ObjectMap_t>;
-using IndexKeyPair_t = std::pair<int, int>;
-using PtrsCache_t = std::list<void *>;
+using Inbox_t = LockLessQ<PointerNode>;
+
+/// @brief Address range of a slab; lets us map any pointer back to its pool, slab and owner without hashing
+/// @note owner_ and pool_ are nullptr once the owner thread has exited and the slab is orphaned
+typedef struct ChunkRange {
+  uintptr_t begin_;
+  uintptr_t end_;
+  ObjectPool_t *pool_;
+  Slab_t *slab_;
+  MemPool *owner_;
+} ChunkRange_t;
+
+using ChunkTable_t = std::vector<ChunkRange_t>;// Sorted by begin_
 
 class MemPool {
  public:
-  static MemPoolPtr_t &getInstance();
+  /// @note Inline so that MEM_POOL() costs a thread-local load and a branch once the pool exists
+  __always_inline static MemPoolPtr_t &getInstance() {
+	if (__builtin_expect(instance_ != nullptr, 1)) {
+	  return instance_;
+	}
+	return createInstance();
+  }
 
   /// @brief Set the Volume of Memory Pool
   /// @param _volume: volume of Pool
   /// @returns void
   void setPerObjectCount(size_t _volume);
 
+  /// @brief Set how pools registered from now on grow once exhausted
+  /// @param _growth: growth mode, slab volume and cap; NONE restores the calloc-per-object fallback
+  /// @returns void
+  void setGrowthPolicy(const GrowthPolicy_t &_growth) { config_.growth_ = _growth; }
+
+  /// @brief Set where the slabs of pools registered from now on get their memory
+  /// @param _backing: HEAP (calloc up front), RESERVED (mmap'ed address space, committed on demand,
+  ///                  handed back with madvise once a slab runs empty), HUGE_TRANSPARENT or HUGE_TLB (2MiB pages)
+  /// @note Huge page backings fall back gracefully; stats(true) reports what each pool actually got
+  /// @returns void
+  void setSlabBacking(SlabBacking _backing) { config_.backing_ = _backing; }
+
+  /// @brief Place the slabs of pools registered from now on on the NUMA node of the calling thread
+  /// @param _enabled: true to bind every new slab to the node of the thread creating it
+  /// @note A no-op on single-node systems apart from the node reported by stats(true)
+  /// @returns void
+  void setNumaLocal(bool _enabled) { config_.numaLocal_ = _enabled; }
+
+  /// @brief Set when the slots of pools registered from now on are reset to zero
+  /// @param _zero: NONE, ON_ALLOC, ON_FREE (the default) or ON_FREE_NT (non-temporal stores)
+  /// @note Size class pools keep allocate() zeroed, so they treat NONE as ON_ALLOC
+  /// @returns void
+  void setZeroPolicy(ZeroPolicy _zero) { config_.zero_ = _zero; }
+
+  /// @brief Pad the slots of pools registered from now on to whole cache lines
+  /// @param _enabled: true for objects that are handed to other threads, so that two of them never share a line
+  /// @returns void
+  void setCacheLinePadding(bool _enabled) { config_.padded_ = _enabled; }
+
+  /// @brief Bound the work of a single housekeeping run; what is left over is resumed by the next run
+  /// @param _entries: inbox entries settled per run, 0 for no limit
+  /// @param _micros: time spent per run in microseconds, 0 for no limit
+  /// @note Defaults to houseKeepingSlice_ entries or houseKeepingBudgetUs_, whichever runs out first
+  /// @returns void
+  void setHouseKeepingBudget(size_t _entries, uint64_t _micros) {
+	houseKeepingEntries_ = _entries;
+	houseKeepingMicros_ = _micros;
+  }
+
+  /// @brief Opt-in: serve registered objects from shared size class pools instead of one pool per ID
+  /// @param _enabled: true to share pools between objects of similar size
+  /// @note Only affects objects registered after the call
+  void setSizeClassMode(bool _enabled) { sizeClassMode_ = _enabled; }
+
   /// @brief Should only be called once for each unique object type
   /// @param _id: ID of Object
   /// @param _size: Size of Each Object
   /// @returns true if object type is registered successfully
   bool registerNewObject(int _id, size_t _size);
 
+  /// @brief Same as above, with slots aligned to `_align` instead of alignof(std::max_align_t)
+  /// @param _align: power of two up to the page size
+  bool registerNewObject(int _id, size_t _size, size_t _align);
+
+  /// @brief Same as above, with a pool specific configuration instead of the one set through the setters
+  /// @param _config: growth policy and slab backing of this pool only
+  bool registerNewObject(int _id, size_t _size, const PoolConfig_t &_config);
+
+  /// @brief Same as above, with both a slot alignment and a pool specific configuration
+  bool registerNewObject(int _id, size_t _size, size_t _align, const PoolConfig_t &_config);
+
   /// @brief Should only be called once for each unique object type passed as Template Argument
+  /// @param _align: slot alignment if stricter than alignof(T), up to the page size
   /// @returns true if object type is registered successfully
   template<typename T>
-  __always_inline bool registerType() { return registerNewObject(typeid(T).hash_code(), sizeof(T)); }
+  __always_inline bool registerType(size_t _align = alignof(T)) {
+	if (!registerNewObject(typeId<T>(), sizeof(T), std::max(_align, alignof(T)))) {
+	  return false;
+	}
+	bindTypeSlot(typeSlot<T>(), typeId<T>());
+	return true;
+  }
 
   /// @brief Check if Type T is already registered
   /// @returns true if T is registered or false otherwise
   template<typename T>
   __always_inline bool isRegisteredType() const {
-	const auto &itr = objectMap_->find(typeid(T).hash_code());
+	if (typePool(typeSlot<T>()) != nullptr) {
+	  return true;
+	}
+	const auto &itr = objectMap_->find(typeId<T>());
 	return (itr != objectMap_->end());
   }
 
@@ -61,21 +145,151 @@ class MemPool {
   template<typename T>
   __always_inline T *getBuffer(int _id) { return (T *)(getBuffer(_id)); }
 
-  /// @brief  To get buffer of a required type
-  /// @returns: a pre-allocated memory of specified type
+  /// @brief  To get buffer of a required type, registering T on first use
+  /// @note The pool is found by indexing with the slot of T, without hashing
+  /// @returns: a pre-allocated memory of specified type (nullptr if T could not be registered or due to mem exhaustion)
+  template<typename T>
+  __always_inline T *getBuffer() {
+	auto pool = typePool(typeSlot<T>());
+	if (__builtin_expect(pool == nullptr, 0)) {
+	  pool = registerTypeSlot(typeSlot<T>(), typeId<T>(), sizeof(T), alignof(T));
+	  if (pool == nullptr) {
+		return nullptr;
+	  }
+	}
+#if MEMPOOL_LATENCY_HISTOGRAM
+	const LatencyTimer timer(&getLatency_);
+#endif
+	return (T *)getBufferFrom(pool);
+  }
+
+  /// @brief  To get a buffer that T is constructed in right away, from a pool of its own that is never zeroed
+  /// @note The pool is registered on first use with ZeroPolicy::NONE, taking the alignment and settings of the pool
+  ///       of T if there is one by then. Used by mem::make_unique and mem::make_shared
+  /// @returns: a pre-allocated memory of specified type, with unspecified contents (nullptr if T could not be registered)
   template<typename T>
-  __always_inline T *getBuffer() { return getBuffer<T>(typeid(T).hash_code()); }
+  __always_inline T *getRawBuffer() {
+	auto pool = typePool(typeSlot<RawSlot<T>>());
+	if (__builtin_expect(pool == nullptr, 0)) {
+	  pool = registerRawSlot(typeSlot<RawSlot<T>>(), typeId<RawSlot<T>>(), typeId<T>(), sizeof(T), alignof(T));
+	  if (pool == nullptr) {
+		return nullptr;
+	  }
+	}
+#if MEMPOOL_LATENCY_HISTOGRAM
+	const LatencyTimer timer(&getLatency_);
+#endif
+	return (T *)getBufferFrom(pool, false);
+  }
+
+  /// @brief  malloc-style allocation from the size class pools; no registration needed
+  /// @param _size: number of bytes wanted
+  /// @returns: a zeroed buffer of at least `_size` bytes (calloc'ed if larger than the biggest size class)
+  void *allocate(size_t _size);
+
+  /// @brief  Release a buffer from allocate(); any thread may call this
+  /// @param _ptr: Pointer to release
+  static void deallocate(void *_ptr) { returnBuffer(_ptr); }
+
+  /// @brief  To get `_count` buffers of given type in one call
+  /// @param _id: ID of Object
+  /// @param _out: array receiving at least `_count` pointers
+  /// @param _count: number of buffers wanted
+  /// @returns: number of buffers written to `_out` (0 if the key is invalid)
+  /// @note Lookup, threshold check and housekeeping happen once per batch instead of once per buffer
+  size_t getBuffers(int _id, void **_out, size_t _count);
+
+  /// @brief  To get `_count` buffers of a required type in one call
+  template<typename T>
+  __always_inline size_t getBuffers(int _id, T **_out, size_t _count) { return getBuffers(_id, (void **)_out, _count); }
+
+  /// @brief  To get `_count` buffers of a required type in one call, registering T on first use
+  /// @returns: number of buffers written to `_out` (0 if T could not be registered)
+  template<typename T>
+  __always_inline size_t getBuffers(T **_out, size_t _count) {
+	auto pool = typePool(typeSlot<T>());
+	if (__builtin_expect(pool == nullptr, 0)) {
+	  pool = registerTypeSlot(typeSlot<T>(), typeId<T>(), sizeof(T), alignof(T));
+	  if (pool == nullptr) {
+		return 0;
+	  }
+	}
+	return getBuffersFrom(pool, (void **)_out, _count);
+  }
 
   /// @brief  To return the buffer back to MemPool
   /// @param _ptr: Pointer to return
   /// @returns void
   static void returnBuffer(void *_ptr);
 
+  /// @brief  To return `_count` buffers back to MemPool in one call
+  /// @param _ptrs: Pointers to return; nullptr entries are skipped
+  /// @param _count: number of entries in `_ptrs`
+  /// @returns void
+  static void returnBuffers(void **_ptrs, size_t _count);
+
+  /// @brief  To return `_count` typed buffers back to MemPool in one call
+  template<typename T>
+  __always_inline static void returnBuffers(T **_ptrs, size_t _count) { returnBuffers((void **)_ptrs, _count); }
+
+  /// @brief  Check if `_ptr` is a slot of any thread's pools; any thread may call this
+  /// @note Overflow blocks are only recognized when built with MEMPOOL_TRACK_OVERFLOW
+  /// @returns true if returnBuffer() is the way to release `_ptr`
+  static bool isPoolBuffer(const void *_ptr);
+
   /// @brief  To get current Memory Pool Stats
   /// @param detailed: specify true if we need detailed stats for the MemPool
   /// @returns Stats for the Current Thread's Memory Pool
   [[nodiscard]] std::string stats(bool detailed = false) const;
 
+  /// @brief  Snapshot of the counters of this thread's MemPool, without any lock
+  /// @note Safe to call from any thread; counters are read individually so they may be a few operations apart
+  /// @returns POD copy of the counters (and the latency histograms when built with MEMPOOL_LATENCY_HISTOGRAM)
+  [[nodiscard]] ThreadStats_t threadStats() const;
+
+  /// @brief  Snapshot of every pool of this thread's MemPool, without any lock
+  /// @param _out: array receiving up to `_max` entries; registered IDs first, then the size class pools in use
+  /// @param _max: capacity of `_out`
+  /// @note Must be called on the owner thread, since registration changes the set of pools
+  /// @returns number of pools, which may exceed `_max`
+  size_t poolStats(PoolStats_t *_out, size_t _max) const;
+
+  /// @brief  Call `_visit` for every live MemPool of the process, each one locked against registration and growth
+  /// @note `_visit` must not create a MemPool, i.e. must not call MEM_POOL() on a thread that has none yet
+  /// @returns void
+  static void forEachInstance(const std::function<void(const MemPool &)> &_visit);
+
+  /// @brief  Occupancy per type ID (and per size class) summed over every live MemPool
+  /// @returns one entry per type, ordered by ID then object size
+  static std::vector<TypeStats_t> typeStats();
+
+  /// @brief  Detailed stats of every live MemPool followed by the per type totals
+  static std::string registryStats();
+
+  /// @brief  Write registryStats() to `_path`, replacing the file
+  /// @returns true on success
+  static bool dumpStats(const std::string &_path);
+
+  /// @brief  Dump the stats of every MemPool to `_path` whenever the process gets `_signal`
+  /// @note The handler only wakes a dumper thread, so it is safe at any point of the program
+  /// @returns false if the dump was already enabled or could not be set up, in which case nothing is left installed
+  static bool enableStatsDumpOnSignal(const std::string &_path, int _signal = SIGUSR1);
+
+  /// @brief  Settle the frees of other threads on a low priority background thread instead of in getBuffer
+  /// @param _idleMicros: sleep of the reclaimer once every inbox is empty
+  /// @note Settled slots go to a lock-free queue per pool, from which the owner hands them out before anything else;
+  ///       owners still settle their own inbox at the upper threshold, and still trim their own slabs
+  /// @returns false if the reclaimer is already running
+  static bool startReclaimer(uint64_t _idleMicros = reclaimerIdleUs_);
+
+  /// @brief  Stop the reclaimer thread, if running, and wait for it; owners settle their inbox again from then on
+  /// @note The slots it settled for the calling thread go back to their slabs right away; every other thread gives
+  ///       its own back at its next housekeeping
+  /// @returns void
+  static void stopReclaimer();
+
+  [[nodiscard]] static bool isReclaimerRunning();
+
   /// @brief To check the sanity of All Available Memory Pools
   /// @returns TRUE if Memory Pools are sane or FALSE if one of them is Overflowed
   bool validatePools() const;
@@ -86,7 +300,42 @@ class MemPool {
   ~MemPool();
 
  private:
-  /// @brief Return the Pointer for some others thread's MemPool
+  static MemPoolPtr_t &createInstance();
+
+  /// @brief ID T is registered under; IDs are ints, so this is the truncated hash registerNewObject stores
+  template<typename T>
+  __always_inline static int typeId() { return (int)typeid(T).hash_code(); }
+
+  /// @brief Process-wide index of T, handed out on first use; the same on every thread
+  template<typename T>
+  __always_inline static size_t typeSlot() {
+	static const size_t slot = nextTypeSlot();
+	return slot;
+  }
+
+  static size_t nextTypeSlot();
+
+  /// @brief Stands in for T where the raw buffers of T need a slot and an ID apart from those of T
+  template<typename T>
+  struct RawSlot {};
+
+  /// @returns the pool bound to `_slot` on this thread, nullptr if none yet
+  __always_inline ObjectPool_t *typePool(size_t _slot) const {
+	return (_slot < typePools_.size()) ? typePools_[_slot] : nullptr;
+  }
+
+  /// @brief Point `_slot` at the pool registered under `_id`
+  void bindTypeSlot(size_t _slot, int _id);
+
+  /// @brief Slow path of getBuffer<T>(): register the type under `_id` unless done already, then bind `_slot`
+  /// @returns the pool bound to `_slot`, nullptr if the type could not be registered or `_id` holds smaller slots
+  ObjectPool_t *registerTypeSlot(size_t _slot, int _id, size_t _size, size_t _align);
+
+  /// @brief Slow path of getRawBuffer<T>(): same as above, registering with ZeroPolicy::NONE
+  /// @param _typeId: ID of T; its pool, if registered already, lends the raw pool its alignment and settings
+  ObjectPool_t *registerRawSlot(size_t _slot, int _id, int _typeId, size_t _size, size_t _align);
+
+  /// @brief Return the Pointer to some other thread's MemPool by pushing it on the owner's inbox
   /// @param _ptr: Pointer to Return
   /// @returns void
   static void returnBufferSpecial(void *_ptr);
@@ -97,11 +346,28 @@ class MemPool {
   /// @returns TRUE if HouseKeeping is Allowed or FALSE otherwise
   bool doHouseKeepingIfAllowed();
 
-  /// @brief This function checks the health of memory pool. If LowerThreshold/UpperThreshold is met and system is not overloaded it performs a HouseKeeping
-  /// @note This Routine can take some time so its very important that System is not overloaded During its execution
-  /// @note Can return prematurely if system goes to OverLoad Conditions
+  /// @brief Settle slots returned by other threads, then trim once the inbox is empty, within the housekeeping budget
+  /// @note Bounded so that a pile of remote frees never lands on a single getBuffer call
   void doHouseKeeping();
 
+  /// @brief Reclaimer thread only: settle up to reclaimerBatch_ entries of our inbox into the reclaimed queues
+  /// @note registryLock_ must be held, which keeps us alive
+  /// @returns number of entries settled
+  size_t reclaimInbox();
+
+  /// @brief Give the slots in the reclaimed queue of every pool back to their slabs
+  /// @returns false if `_deadline` passed first
+  bool flushReclaimed(std::chrono::steady_clock::time_point _deadline);
+
+  /// @brief Give the slots in the reclaimed queue of `pool` back to their slabs
+  /// @returns false if `_deadline` passed first
+  bool flushReclaimed(ObjectPool_t *pool, std::chrono::steady_clock::time_point _deadline);
+
+  /// @brief A trim is wanted, one was cut short by the budget, or the reclaimer left slots for us to give back
+  [[nodiscard]] bool isTrimDue() const {
+	return pendingTrim_ || trimCursor_ != 0 || reclaimedPending_.load(std::memory_order_relaxed);
+  }
+
   /// @brief Checks if the current Mem Pool has met the UpperThreshold
   /// @returns TRUE if UpperThreshold is Met
   bool isUpperThresholdMet() const { return (currPool_->count_ >= (currPool_->totalCount_ * upperThreshold_)); }
@@ -110,49 +376,161 @@ class MemPool {
   /// @returns TRUE if Lower Threshold is Met
   bool isLowerThresholdMet() { return (currPool_->count_ >= (currPool_->totalCount_ * lowerThreshold_)); }
 
-  static void doCleanup(ObjectPoolPtr_t &obj, size_t index);
+  void doCleanup(ObjectPool_t *obj, Slab_t *slab, size_t index);
+
+  /// @brief Ask for a trim if `slab` has nothing in use anymore
+  void checkIdle(const ObjectPool_t *obj, const Slab_t *slab) {
+	if (slab->count_ == 0 && (slab != obj->slabs_.front().get() || slab->isPurgeable())) {
+	  pendingTrim_ = true;// The slab is idle; let the next housekeeping decide whether to give it back
+	}
+  }
+
+  /// @brief Give fully free grown slabs, and the pages of empty RESERVED slabs, back to the OS
+  /// @param _deadline: stop after the pool being trimmed once this has passed; the next call resumes there
+  void trimPools(std::chrono::steady_clock::time_point _deadline);
 
-  static void *getFromReturnBuffer();
+  void trimPool(ObjectPool_t *pool);
 
-  static void pushToReturnBuffer(void *ptr);
+  /// @brief Add a slab to `pool`, registering its range for pointer lookups
+  /// @returns false if the growth policy of the pool forbids it
+  bool growPool(ObjectPool_t *pool);
+
+  /// @brief Pop a slot from `pool`, doing housekeeping or falling back to calloc as required
+  /// @param _zero: apply the zero policy of the pool; false when the caller constructs over the slot anyway
+  void *getBufferFrom(ObjectPool_t *pool, bool _zero = true);
+
+  /// @brief Batch allocation behind both getBuffers() overloads
+  size_t getBuffersFrom(ObjectPool_t *pool, void **_out, size_t _count);
+
+  /// @brief Make the slabs of a newly created pool known to the pointer lookups
+  void addPool(const ObjectPoolPtr_t &pool);
+
+  void addChunk(ObjectPool_t *pool, Slab_t *slab);
+
+  void removeChunk(const Slab_t *slab);
+
+  /// @brief Size class pool serving `_size` bytes, created on first use
+  const ObjectPoolPtr_t &getSizeClassPool(size_t _size);
+
+  [[nodiscard]] bool isSizeClassPool(const ObjectPool_t *pool) const;
+
+  /// @brief Allocate a block outside of the pool once it is exhausted
+  void *getOverflowBlock(size_t _size);
+
+  /// @brief Binary search `table` for the chunk containing `_ptr`
+  /// @returns the chunk or nullptr if `_ptr` is not inside any of them
+  static const ChunkRange_t *findChunk(const ChunkTable_t &table, const void *_ptr);
+
+  static void insertChunk(ChunkTable_t &table, const ChunkRange_t &chunk);
+
+  /// @brief Release a block that was calloc'ed because its pool was exhausted
+  static void releaseOverflowBlock(void *_ptr);
+
+  /// @brief Return `_ptr` to an orphaned slab and free the slab once its last buffer is back
+  /// @note globalChunksLock_ must be held
+  static void releaseOrphan(const ChunkRange_t *chunk, void *_ptr);
+
+  /// @brief Hand a copy of globalChunks_ to the lock-free readers and free the copy it replaces
+  /// @note globalChunksLock_ must be held; waits for the readers of the old copy to leave
+  static void publishChunks();
 
-  static size_t getReturnBufferSize();
 
  private:
   static thread_local MemPoolPtr_t instance_;
 
   ObjectMapPtr_t objectMap_;
 
-  //                  ptr,    index, key
-  std::unordered_map<void *, IndexKeyPair_t> dispatched_;
+  std::vector<ObjectPool_t *> typePools_;// Indexed by typeSlot<T>(); owned through objectMap_
+
+  std::vector<ObjectPoolPtr_t> sizeClassPools_;// Indexed by size class, nullptr until first used
 
-  static SpinLock sharedBufferLock_;
+  bool sizeClassMode_;
 
-  static PtrsCache_t sharedBuffer_;
+  PoolConfig_t config_;// Applied to pools registered from now on
+
+  bool pendingTrim_;// A slab became empty since the last housekeeping
+
+  size_t trimCursor_;// Pool an interrupted trim resumes at; registered pools first, then the size class pools
+
+  std::chrono::steady_clock::time_point deferredUntil_;// Housekeeping was deferred; decide again once this has passed
+
+  size_t deferSkips_;// Calls left before the clock is read again while deferred
+
+  size_t houseKeepingEntries_;
+
+  uint64_t houseKeepingMicros_;
+
+  ChunkTable_t chunks_;// Chunks owned by this thread; no lock needed
+
+  static SpinLock registryLock_;
+
+  static std::vector<MemPool *> registry_;// Every live MemPool
+
+  SpinLock poolsLock_;// Held by us while adding or removing pools and slabs, and by registry walkers
+
+  static SpinLock globalChunksLock_;
+
+  static ChunkTable_t globalChunks_;// Chunks of every thread; written under globalChunksLock_, then published
+
+  static std::atomic<const ChunkTable_t *> chunkSnapshot_;// Published copy of globalChunks_; read inside chunksEpoch_
+
+  static ReadEpoch chunksEpoch_;// Keeps a snapshot and the owners in it alive while it is read
+
+  static SlabVec_t orphanSlabs_;// Slabs of exited threads with buffers still out; guarded by globalChunksLock_
+
+#if MEMPOOL_TRACK_OVERFLOW
+  static SpinLock overflowLock_;
+
+  static std::unordered_set<void *> overflowBlocks_;// Debug only: every live calloc'ed overflow block
+#endif
+
+  Inbox_t inbox_;// Slots freed by other threads; nodes live inside the freed slots themselves
+
+  SpinLock inboxLock_;// Only tried, never waited for; keeps the owner and the reclaimer from consuming the inbox at once
+
+  std::atomic<bool> reclaimedPending_;// Set by the reclaimer once a reclaimed queue grows past reclaimedBacklog_
 
   size_t volume_;
 
-  size_t getBufCount_;
+  // Counters below are written by this thread only and read by threadStats() from anywhere
+
+  base::Counter<size_t> registeredCount_;
 
-  size_t retBufCount_;
+  base::Counter<uint64_t> getBufCount_;
+
+  base::Counter<uint64_t> retBufCount_;
 
   const pthread_t myTid_;
 
-  static std::atomic<bool> houseKeepingInProg_;
+  base::Counter<uint64_t> houseKeepingCount_;
+
+  base::Counter<uint64_t> houseKeepingDeferCount_;
+
+  base::Counter<uint64_t> mandatoryHouseKeepingCount_;
+
+  base::Counter<uint64_t> houseKeepingNs_;
+
+  base::Counter<uint> occupancy_;// CPU occupancy of this thread at the last housekeeping decision
+
+  base::Counter<uint64_t> freeMemoryBlocks_;
+
+  base::Counter<uint64_t> returnedFreeMemoryBlocks_;
 
-  static SpinLock houseKeepingLock_;
+  base::Counter<uint64_t> slabGrowCount_;
 
-  uint64_t houseKeepingCount_;
+  base::Counter<uint64_t> slabReleaseCount_;
 
-  uint64_t houseKeepingDeferCount_;
+  base::Counter<uint64_t> slabPurgeCount_;
 
-  uint64_t mandatoryHouseKeepingCount_;
+  base::Counter<uint64_t> reclaimedCount_;// Written by the reclaimer thread only
 
-  uint64_t freeMemoryBlocks_;
+#if MEMPOOL_LATENCY_HISTOGRAM
+  LatencyRecorder getLatency_;
 
-  uint64_t returnedFreeMemoryBlocks_;
+  LatencyRecorder returnLatency_;
+#endif
 
-  ObjectPoolPtr_t currPool_;
+  ObjectPool_t *currPool_;
 };
 
 #define MEM_POOL() MemPool::getInstance()
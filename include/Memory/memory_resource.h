@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../MemPool.h"
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+namespace mem {
+
+  /// @brief std::pmr::memory_resource over the size class pools of the calling thread's MemPool
+  /// @note Stateless: memory from any instance may be released through any other, and on any thread.
+  ///       Over-aligned requests go to aligned operator new instead
+  class MemPoolResource : public std::pmr::memory_resource {
+   protected:
+	void *do_allocate(size_t bytes, size_t alignment) override {
+	  if (alignment > alignof(std::max_align_t)) {
+		return ::operator new(bytes, std::align_val_t(alignment));
+	  }
+	  auto ptr = MEM_POOL()->allocate(bytes);
+	  if (ptr == nullptr) {
+		throw std::bad_alloc();// The contract of memory_resource; MemPool itself reports by returning nullptr
+	  }
+	  return ptr;
+	}
+
+	void do_deallocate(void *ptr, size_t, size_t alignment) override {
+	  if (alignment > alignof(std::max_align_t)) {
+		::operator delete(ptr, std::align_val_t(alignment));
+		return;
+	  }
+	  MemPool::deallocate(ptr);
+	}
+
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+	  return dynamic_cast<const MemPoolResource *>(&other) != nullptr;
+	}
+  };
+
+  /// @brief Process-wide MemPoolResource, like std::pmr::new_delete_resource()
+  inline MemPoolResource *pool_resource() {
+	static MemPoolResource resource;
+	return &resource;
+  }
+}// namespace mem
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../MemPool.h"
+#include <cstddef>
+#include <new>
+
+namespace mem {
+
+  /// @brief Stateless STL allocator over the size class pools of the calling thread's MemPool
+  /// @note Node-based containers allocate one node at a time, so each node lands in the size class of the node;
+  ///       vector-like growth past the biggest size class falls back to calloc inside MemPool
+  template<typename T>
+  class PoolAllocator {
+   public:
+	using value_type = T;
+
+	PoolAllocator() noexcept = default;
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+	T *allocate(size_t count) {
+	  if (alignof(T) > alignof(std::max_align_t)) {
+		return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+	  }
+	  auto ptr = MEM_POOL()->allocate(count * sizeof(T));
+	  if (ptr == nullptr) {
+		throw std::bad_alloc();// The contract of Allocator; MemPool itself reports by returning nullptr
+	  }
+	  return static_cast<T *>(ptr);
+	}
+
+	void deallocate(T *ptr, size_t) noexcept {
+	  if (alignof(T) > alignof(std::max_align_t)) {
+		::operator delete(ptr, std::align_val_t(alignof(T)));
+		return;
+	  }
+	  MemPool::deallocate(ptr);
+	}
+  };
+
+  template<typename T, typename U>
+  bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) noexcept { return true; }
+
+  template<typename T, typename U>
+  bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) noexcept { return false; }
+}// namespace mem
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../MemPool.h"
+#include <cstddef>
+#include <type_traits>
+
+namespace mem {
+
+  /// @brief Bytes in front of a pooled array that hold its length, so that its deleter stays stateless
+  constexpr size_t poolArrayCookie_ = alignof(std::max_align_t);
+
+  /// @brief A U may be owned, and deleted, through a T *: T is U, or T has a virtual destructor, which destroys all of
+  ///        U and lets the deleter find the start of the slot even when T is a base at a non-zero offset
+  template<typename U, typename T>
+  using is_pool_convertible = std::integral_constant<bool, std::is_convertible<U *, T *>::value
+																&& (std::is_same<std::remove_cv_t<U>, std::remove_cv_t<T>>::value
+																	|| std::has_virtual_destructor<T>::value)>;
+
+  /// @brief Default deleter of the mem smart pointers: destroy the object and return its buffer to MemPool
+  /// @note Any thread may delete; returnBuffer routes the buffer to the pool, and thread, it came from
+  template<typename T>
+  struct pool_delete {
+	pool_delete() noexcept = default;
+
+	template<typename U, typename = std::enable_if_t<is_pool_convertible<U, T>::value>>
+	pool_delete(const pool_delete<U> &) noexcept {}
+
+	void operator()(T *ptr) const {
+	  if (ptr != nullptr) {
+		const auto slot = slotOf(ptr);// While the object is still alive to tell its dynamic type
+		ptr->~T();
+		MemPool::returnBuffer(slot);
+	  }
+	}
+
+   private:
+	/// @brief The slot starts at the most derived object, which a base pointer may point inside of
+	static void *slotOf(T *ptr) {
+	  if constexpr (std::is_polymorphic<T>::value) {
+		return const_cast<void *>(dynamic_cast<const volatile void *>(ptr));
+	  } else {
+		return const_cast<void *>(static_cast<const volatile void *>(ptr));
+	  }
+	}
+  };
+
+  /// @brief Deleter of arrays from mem::make_unique<T[]>: destroy the elements, last first, and release the slot
+  template<typename T>
+  struct pool_delete<T[]> {
+	pool_delete() noexcept = default;
+
+	void operator()(T *ptr) const {
+	  if (ptr == nullptr) {
+		return;
+	  }
+	  auto base = reinterpret_cast<unsigned char *>(ptr) - poolArrayCookie_;
+	  if (!std::is_trivially_destructible<T>::value) {
+		for (auto count = *reinterpret_cast<size_t *>(base); count > 0; --count) {
+		  ptr[count - 1].~T();
+		}
+	  }
+	  MemPool::deallocate(base);
+	}
+  };
+}// namespace mem
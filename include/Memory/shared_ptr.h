@@ -1,90 +1,341 @@
 #pragma once
 
 #include "../MemPool.h"
+#include "pool_delete.h"
+#include <atomic>
+#include <memory>
+#include <utility>
 
 namespace mem {
 
   using uint = unsigned int;
 
+  namespace detail {
+	/// @brief Counts of a shared object; lives in a pool slot, next to the object when made by make_shared
+	class control_block {
+	 public:
+	  explicit control_block(bool local) : strong_(1), weak_(1), local_(local) {}
+
+	  virtual ~control_block() = default;
+
+	  void add_strong() { increment(strong_); }
+
+	  /// @brief Take a strong reference unless the object is gone already (weak_ptr::lock)
+	  bool try_add_strong() {
+		auto count = strong_.load(std::memory_order_relaxed);
+		if (local_) {
+		  if (count == 0) {
+			return false;
+		  }
+		  strong_.store(count + 1, std::memory_order_relaxed);
+		  return true;
+		}
+		while (count != 0) {
+		  if (strong_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			return true;
+		  }
+		}
+		return false;
+	  }
+
+	  void release_strong() {
+		if (decrement(strong_) == 0) {
+		  dispose();
+		  release_weak();// The one the strong references held together
+		}
+	  }
+
+	  void add_weak() { increment(weak_); }
+
+	  void release_weak() {
+		if (decrement(weak_) == 0) {
+		  destroy();
+		}
+	  }
+
+	  [[nodiscard]] long use_count() const { return strong_.load(std::memory_order_relaxed); }
+
+	 protected:
+	  /// @brief Destroy the object
+	  virtual void dispose() = 0;
+
+	  /// @brief Destroy this block and give its slot back
+	  virtual void destroy() = 0;
+
+	 private:
+	  void increment(std::atomic<long> &count) {
+		if (local_) {
+		  count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		} else {
+		  count.fetch_add(1, std::memory_order_relaxed);
+		}
+	  }
+
+	  /// @returns the new count
+	  long decrement(std::atomic<long> &count) {
+		if (local_) {
+		  const auto value = count.load(std::memory_order_relaxed) - 1;
+		  count.store(value, std::memory_order_relaxed);
+		  return value;
+		}
+		return count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	  }
+
+	  std::atomic<long> strong_;
+	  std::atomic<long> weak_;// weak_ptrs, plus one for all the shared_ptrs together
+	  const bool local_;      // Counts are plain loads and stores; the object must stay on one thread
+	};
+
+	/// @brief Block and object in one pool slot
+	template<typename T>
+	class inplace_block final : public control_block {
+	 public:
+	  template<typename... Args>
+	  explicit inplace_block(bool local, Args &&...args) : control_block(local) {
+		new (storage_) T(std::forward<Args>(args)...);
+	  }
+
+	  T *object() { return reinterpret_cast<T *>(storage_); }
+
+	 protected:
+	  void dispose() override { object()->~T(); }
+
+	  void destroy() override {
+		this->~inplace_block();
+		MemPool::returnBuffer(this);
+	  }
+
+	 private:
+	  alignas(T) unsigned char storage_[sizeof(T)];
+	};
+
+	/// @brief Block of an object made elsewhere, released through `Deleter`
+	template<typename T, typename Deleter>
+	class pointer_block final : public control_block {
+	 public:
+	  pointer_block(T *ptr, Deleter deleter) : control_block(false), ptr_(ptr), deleter_(std::move(deleter)) {}
+
+	 protected:
+	  void dispose() override { deleter_(ptr_); }
+
+	  void destroy() override {
+		this->~pointer_block();
+		MemPool::returnBuffer(this);
+	  }
+
+	 private:
+	  T *ptr_;
+	  Deleter deleter_;
+	};
+  }// namespace detail
+
+  template<typename T>
+  class weak_ptr;
+
+  /// @brief Reference counted pointer whose count lives in a pool slot; copies may be shared between threads
   template<typename T>
   class shared_ptr {
    public:
-	shared_ptr() : ptr_(nullptr), ref_count_(new uint(0)) {}
+	shared_ptr() noexcept : ptr_(nullptr), block_(nullptr) {}
 
-	explicit shared_ptr(T *ptr) : ptr_(ptr), ref_count_(new uint(1)) {}
+	shared_ptr(std::nullptr_t) noexcept : shared_ptr() {}
 
-	shared_ptr(const shared_ptr &other) {
-	  this->ptr_ = other.ptr_;
-	  this->ref_count_ = other.ref_count_;
-	  if (other.ptr_ != nullptr) {
-		(*this->ref_count_)++;// Increase the Ref-Count
+	/// @brief Adopt a MemPool buffer holding a T, destroyed and returned with mem::pool_delete, or a T from plain new,
+	///        released with delete
+	/// @note Pass pool_delete<T>() explicitly for a getBuffer() result that may be an overflow block, since those are
+	///       only told apart from plain new with MEMPOOL_TRACK_OVERFLOW
+	explicit shared_ptr(T *ptr) : ptr_(ptr), block_(nullptr) {
+	  if (MemPool::isPoolBuffer(ptr)) {
+		adopt(pool_delete<T>());
+	  } else {
+		adopt(std::default_delete<T>());
 	  }
 	}
 
-	shared_ptr(shared_ptr &&old) noexcept {
-	  this->ptr_ = old.ptr_;
-	  this->ref_count_ = old.ref_count_;
+	/// @brief Adopt `ptr`, to be released with `deleter`
+	template<typename Deleter>
+	shared_ptr(T *ptr, Deleter deleter) : ptr_(ptr), block_(nullptr) {
+	  adopt(std::move(deleter));
+	}
+
+	shared_ptr(const shared_ptr &other) noexcept : ptr_(other.ptr_), block_(other.block_) {
+	  if (block_ != nullptr) {
+		block_->add_strong();
+	  }
+	}
 
-	  // cleanup old
+	shared_ptr(shared_ptr &&old) noexcept : ptr_(old.ptr_), block_(old.block_) {
 	  old.ptr_ = nullptr;
-	  old.ref_count_ = nullptr;
+	  old.block_ = nullptr;
 	}
 
-	shared_ptr &operator=(const shared_ptr &other) {
-	  if (this != &other) {
-		adjust_ref_count();
-		this->ptr_ = other.ptr_;
-		this->ref_count_ = other.ref_count_;
-		if (other.ptr_ != nullptr) {
-		  (*this->ref_count_)++;// Increase the Ref-Count
-		}
+	template<typename U>
+	shared_ptr(const shared_ptr<U> &other) noexcept : ptr_(other.ptr_), block_(other.block_) {
+	  if (block_ != nullptr) {
+		block_->add_strong();
 	  }
 	}
 
+	template<typename U>
+	shared_ptr(shared_ptr<U> &&old) noexcept : ptr_(old.ptr_), block_(old.block_) {
+	  old.ptr_ = nullptr;
+	  old.block_ = nullptr;
+	}
+
+	shared_ptr &operator=(const shared_ptr &other) noexcept {
+	  shared_ptr(other).swap(*this);
+	  return *this;
+	}
+
 	shared_ptr &operator=(shared_ptr &&old) noexcept {
-	  adjust_ref_count();
-	  this->ptr_ = old.ptr_;
-	  this->ref_count_ = old.ref_count_;
+	  shared_ptr(std::move(old)).swap(*this);
+	  return *this;
+	}
+
+	~shared_ptr() {
+	  if (block_ != nullptr) {
+		block_->release_strong();
+	  }
+	}
+
+	void reset() noexcept { shared_ptr().swap(*this); }
 
-	  old.ref_count_ = old.ptr_ = nullptr;
+	void swap(shared_ptr &other) noexcept {
+	  std::swap(ptr_, other.ptr_);
+	  std::swap(block_, other.block_);
 	}
 
-	[[nodiscard]] uint get_count() const { return *this->ref_count_; }
+	[[nodiscard]] long use_count() const { return (block_ != nullptr) ? block_->use_count() : 0; }
+
+	[[nodiscard]] uint get_count() const { return use_count(); }
 
 	T *get() const { return this->ptr_; }
 
 	T *operator->() const { return this->ptr_; }
 
-	T &operator*() const { return this->ptr_; }
+	T &operator*() const { return *this->ptr_; }
 
-	void *operator new(size_t) { return shared_ptr<T>(); }
+	explicit operator bool() const { return ptr_ != nullptr; }
 
-	void operator delete(void *_this) { ((shared_ptr<T> *)_this)->adjust_ref_count(); }
+   private:
+	template<typename U>
+	friend class shared_ptr;
 
-	~shared_ptr() { adjust_ref_count(); }
+	template<typename U>
+	friend class weak_ptr;
 
-   private:
-	void adjust_ref_count() {
-	  (*ref_count_)--;
-	  if (*ref_count_ == 0) {
-		if (ptr_ != nullptr)
-		  MemPool::returnBuffer(ptr_);
-		delete ref_count_;
+	template<typename U, typename... Args>
+	friend shared_ptr<U> make_shared_in_pool(bool local, Args &&...args);
+
+	/// @note Block first, so that it can't be taken for the (pointer, deleter) constructor
+	shared_ptr(detail::control_block *block, T *ptr) noexcept : ptr_(ptr), block_(block) {}
+
+	/// @brief Put ptr_ under a block that releases it with `deleter`; released right away if no block can be had
+	template<typename Deleter>
+	void adopt(Deleter deleter) {
+	  using Block = detail::pointer_block<T, Deleter>;
+	  auto buffer = MEM_POOL()->getRawBuffer<Block>();
+	  if (buffer == nullptr) {
+		deleter(ptr_);
+		ptr_ = nullptr;
+		return;
+	  }
+	  block_ = new (buffer) Block(ptr_, std::move(deleter));
+	}
+
+	T *ptr_;
+	detail::control_block *block_;
+  };
+
+  /// @brief Non-owning observer of a shared_ptr; lock() to use the object
+  template<typename T>
+  class weak_ptr {
+   public:
+	weak_ptr() noexcept : ptr_(nullptr), block_(nullptr) {}
+
+	weak_ptr(const shared_ptr<T> &shared) noexcept : ptr_(shared.ptr_), block_(shared.block_) {
+	  if (block_ != nullptr) {
+		block_->add_weak();
+	  }
+	}
+
+	weak_ptr(const weak_ptr &other) noexcept : ptr_(other.ptr_), block_(other.block_) {
+	  if (block_ != nullptr) {
+		block_->add_weak();
+	  }
+	}
+
+	weak_ptr(weak_ptr &&old) noexcept : ptr_(old.ptr_), block_(old.block_) {
+	  old.ptr_ = nullptr;
+	  old.block_ = nullptr;
+	}
+
+	weak_ptr &operator=(const weak_ptr &other) noexcept {
+	  weak_ptr(other).swap(*this);
+	  return *this;
+	}
+
+	weak_ptr &operator=(weak_ptr &&old) noexcept {
+	  weak_ptr(std::move(old)).swap(*this);
+	  return *this;
+	}
+
+	~weak_ptr() {
+	  if (block_ != nullptr) {
+		block_->release_weak();
+	  }
+	}
+
+	/// @returns a shared_ptr to the object, or an empty one if the object is gone
+	shared_ptr<T> lock() const noexcept {
+	  if (block_ != nullptr && block_->try_add_strong()) {
+		return shared_ptr<T>(block_, ptr_);
 	  }
+	  return shared_ptr<T>();
+	}
+
+	[[nodiscard]] bool expired() const { return use_count() == 0; }
+
+	[[nodiscard]] long use_count() const { return (block_ != nullptr) ? block_->use_count() : 0; }
+
+	void reset() noexcept { weak_ptr().swap(*this); }
+
+	void swap(weak_ptr &other) noexcept {
+	  std::swap(ptr_, other.ptr_);
+	  std::swap(block_, other.block_);
 	}
 
    private:
-	T *ptr_ = nullptr;
-	uint *ref_count_ = nullptr;
+	T *ptr_;
+	detail::control_block *block_;
   };
 
+  /// @brief One pool slot for the counts and the object; `local` counts without atomics
   template<typename T, typename... Args>
-  shared_ptr<T> make_shared(Args &&...args) {
-	if (!MEM_POOL()->isRegisteredType<T>()) {
-	  MEM_POOL()->registerType<T>();
+  shared_ptr<T> make_shared_in_pool(bool local, Args &&...args) {
+	using Block = detail::inplace_block<T>;
+	auto buffer = MEM_POOL()->getRawBuffer<Block>();// Registers the block type on first use
+	if (buffer == nullptr) {
+	  return shared_ptr<T>();
+	}
+	try {
+	  auto block = new (buffer) Block(local, std::forward<Args>(args)...);
+	  return shared_ptr<T>(block, block->object());
+	} catch (...) {
+	  MemPool::returnBuffer(buffer);
+	  throw;
 	}
-	auto buffer = MEM_POOL()->getBuffer<T>();
-	auto ptr = new (buffer) T((args)...);
-	return shared_ptr<T>(ptr);
+  }
+
+  template<typename T, typename... Args>
+  shared_ptr<T> make_shared(Args &&...args) {
+	return make_shared_in_pool<T>(false, std::forward<Args>(args)...);
+  }
+
+  /// @brief make_shared for objects that never leave the creating thread: the counts are not atomic
+  /// @note Copies, weak_ptrs and the last release must all happen on one thread at a time
+  template<typename T, typename... Args>
+  shared_ptr<T> make_local_shared(Args &&...args) {
+	return make_shared_in_pool<T>(true, std::forward<Args>(args)...);
   }
 }// namespace mem
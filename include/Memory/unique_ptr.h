@@ -1,46 +1,219 @@
 #pragma once
 
 #include "../MemPool.h"
+#include "pool_delete.h"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
 
 namespace mem {
 
   using uint = unsigned int;
 
-  template<typename T>
-  class unique_ptr {
+  namespace detail {
+	/// @brief Pointer and deleter; an empty deleter is a base, so that it takes no room (EBO)
+	template<typename T, typename Deleter, bool = std::is_empty<Deleter>::value && !std::is_final<Deleter>::value>
+	class unique_storage : private Deleter {
+	 public:
+	  unique_storage(T *ptr, Deleter deleter) : Deleter(std::move(deleter)), ptr_(ptr) {}
+
+	  T *&ptr() { return ptr_; }
+	  T *ptr() const { return ptr_; }
+	  Deleter &deleter() { return *this; }
+	  const Deleter &deleter() const { return *this; }
+
+	 private:
+	  T *ptr_;
+	};
+
+	template<typename T, typename Deleter>
+	class unique_storage<T, Deleter, false> {
+	 public:
+	  unique_storage(T *ptr, Deleter deleter) : ptr_(ptr), deleter_(std::move(deleter)) {}
+
+	  T *&ptr() { return ptr_; }
+	  T *ptr() const { return ptr_; }
+	  Deleter &deleter() { return deleter_; }
+	  const Deleter &deleter() const { return deleter_; }
+
+	 private:
+	  T *ptr_;
+	  Deleter deleter_;
+	};
+
+	/// @brief What unique_ptr<T> and unique_ptr<T[]> have in common; T is the element type
+	template<typename T, typename Deleter>
+	class unique_base {
+	 public:
+	  using pointer = T *;
+	  using element_type = T;
+	  using deleter_type = Deleter;
+
+	  unique_base(const unique_base &) = delete;
+	  unique_base &operator=(const unique_base &) = delete;
+
+	  ~unique_base() {
+		if (storage_.ptr() != nullptr) {
+		  storage_.deleter()(storage_.ptr());
+		}
+	  }
+
+	  T *get() const { return storage_.ptr(); }
+	  explicit operator bool() const { return storage_.ptr() != nullptr; }
+
+	  Deleter &get_deleter() { return storage_.deleter(); }
+	  const Deleter &get_deleter() const { return storage_.deleter(); }
+
+	  /// @brief Give up ownership without destroying anything
+	  T *release() {
+		T *result = nullptr;
+		std::swap(result, storage_.ptr());
+		return result;
+	  }
+
+	  /// @brief Destroy the current object, if any, and own `ptr` instead
+	  void reset(T *ptr = nullptr) {
+		std::swap(ptr, storage_.ptr());
+		if (ptr != nullptr) {
+		  storage_.deleter()(ptr);
+		}
+	  }
+
+	 protected:
+	  unique_base(T *ptr, Deleter deleter) : storage_(ptr, std::move(deleter)) {}
+
+	  unique_base(unique_base &&old) noexcept : storage_(old.release(), std::move(old.get_deleter())) {}
+
+	  void move_from(T *ptr, Deleter &&deleter) {
+		reset(ptr);
+		storage_.deleter() = std::move(deleter);
+	  }
+
+	 private:
+	  unique_storage<T, Deleter> storage_;
+	};
+  }// namespace detail
+
+  /// @brief Sole owner of a pooled object; destroys it and returns its buffer through `Deleter`
+  /// @note As small as a raw pointer with the default, or any other empty, deleter
+  template<typename T, typename Deleter = pool_delete<T>>
+  class unique_ptr : public detail::unique_base<T, Deleter> {
+	using base = detail::unique_base<T, Deleter>;
+
    public:
-	unique_ptr() : ptr_(nullptr) {}
+	unique_ptr() noexcept : base(nullptr, Deleter()) {}
+
+	unique_ptr(std::nullptr_t) noexcept : unique_ptr() {}
 
-	explicit unique_ptr(T *ptr) : ptr_(ptr) {}
+	explicit unique_ptr(T *ptr) noexcept : base(ptr, Deleter()) {}
 
-	unique_ptr(const unique_ptr &) = delete;
-	unique_ptr &operator=(const unique_ptr &) = delete;
+	unique_ptr(T *ptr, Deleter deleter) noexcept : base(ptr, std::move(deleter)) {}
 
-	~unique_ptr() { MemPool::returnBuffer(ptr_); }
+	unique_ptr(unique_ptr &&old) noexcept = default;
 
-	T *operator->() const { return ptr_; }
-	T &operator*() const { return *ptr_; }
+	/// @note Only from U that T can delete: see is_pool_convertible
+	template<typename U, typename E, typename = std::enable_if_t<is_pool_convertible<U, T>::value && !std::is_array<U>::value>>
+	unique_ptr(unique_ptr<U, E> &&old) noexcept : base(old.release(), std::move(old.get_deleter())) {}
 
-	T *get() const { return ptr_; }
-	explicit operator bool() const { return ptr_; }
+	unique_ptr &operator=(unique_ptr &&old) noexcept {
+	  if (this != &old) {
+		this->move_from(old.release(), std::move(old.get_deleter()));
+	  }
+	  return *this;
+	}
+
+	template<typename U, typename E, typename = std::enable_if_t<is_pool_convertible<U, T>::value && !std::is_array<U>::value>>
+	unique_ptr &operator=(unique_ptr<U, E> &&old) noexcept {
+	  this->move_from(old.release(), std::move(old.get_deleter()));
+	  return *this;
+	}
 
-	T *release() {
-	  T *result = nullptr;
-	  std::swap(result, ptr_);
-	  return result;
+	unique_ptr &operator=(std::nullptr_t) noexcept {
+	  this->reset();
+	  return *this;
 	}
 
-   private:
-	T *ptr_;
+	T *operator->() const { return this->get(); }
+	T &operator*() const { return *this->get(); }
   };
 
+  /// @brief Sole owner of a pooled array from make_unique<T[]>
+  template<typename T, typename Deleter>
+  class unique_ptr<T[], Deleter> : public detail::unique_base<T, Deleter> {
+	using base = detail::unique_base<T, Deleter>;
+
+   public:
+	unique_ptr() noexcept : base(nullptr, Deleter()) {}
+
+	unique_ptr(std::nullptr_t) noexcept : unique_ptr() {}
+
+	explicit unique_ptr(T *ptr) noexcept : base(ptr, Deleter()) {}
+
+	unique_ptr(T *ptr, Deleter deleter) noexcept : base(ptr, std::move(deleter)) {}
+
+	unique_ptr(unique_ptr &&old) noexcept = default;
+
+	unique_ptr &operator=(unique_ptr &&old) noexcept {
+	  if (this != &old) {
+		this->move_from(old.release(), std::move(old.get_deleter()));
+	  }
+	  return *this;
+	}
+
+	unique_ptr &operator=(std::nullptr_t) noexcept {
+	  this->reset();
+	  return *this;
+	}
+
+	T &operator[](size_t index) const { return this->get()[index]; }
+  };
+
+  static_assert(sizeof(unique_ptr<int>) == sizeof(int *), "the default deleter must take no room");
+  static_assert(sizeof(unique_ptr<int[]>) == sizeof(int *), "the default array deleter must take no room");
+
   template<typename T, typename... Args>
-  unique_ptr<T> make_unique(Args &&...args) {
-	if (!MEM_POOL()->isRegisteredType<T>()) {
-	  MEM_POOL()->registerType<T>();
+  std::enable_if_t<!std::is_array<T>::value, unique_ptr<T>> make_unique(Args &&...args) {
+	auto buffer = MEM_POOL()->getRawBuffer<T>();// Registers T on first use, without zeroing
+	if (buffer == nullptr) {
+	  return unique_ptr<T>();
+	}
+	try {
+	  return unique_ptr<T>(new (buffer) T(std::forward<Args>(args)...));
+	} catch (...) {
+	  MemPool::returnBuffer(buffer);
+	  throw;
 	}
-	auto buffer = MEM_POOL()->getBuffer<T>();
-	auto ptr = new (buffer) T((args)...);
-	return unique_ptr<T>(ptr);
   }
+
+  /// @brief `count` value-initialized elements, contiguous in one size class slot (calloc'ed past the biggest class)
+  template<typename T>
+  std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0, unique_ptr<T>> make_unique(size_t count) {
+	using Element = std::remove_extent_t<T>;
+	static_assert(alignof(Element) <= poolArrayCookie_, "over-aligned elements are not supported");
+	auto base = static_cast<unsigned char *>(MEM_POOL()->allocate(poolArrayCookie_ + (count * sizeof(Element))));
+	if (base == nullptr) {
+	  return unique_ptr<T>();
+	}
+	*reinterpret_cast<size_t *>(base) = count;
+	auto elements = reinterpret_cast<Element *>(base + poolArrayCookie_);
+	if (!std::is_trivially_default_constructible<Element>::value) {// The slot is zeroed already otherwise
+	  size_t built = 0;
+	  try {
+		for (; built < count; ++built) {
+		  new (elements + built) Element();
+		}
+	  } catch (...) {
+		while (built > 0) {
+		  elements[--built].~Element();
+		}
+		MemPool::deallocate(base);
+		throw;
+	  }
+	}
+	return unique_ptr<T>(elements);
+  }
+
+  /// @brief Arrays of known bound can't be made, as with std::make_unique
+  template<typename T, typename... Args>
+  std::enable_if_t<std::extent<T>::value != 0> make_unique(Args &&...) = delete;
 }// namespace mem
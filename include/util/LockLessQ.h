@@ -1,11 +1,18 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
+/// @brief Multi-producer, single-consumer intrusive queue (Vyukov). T must have `std::atomic<T *> next_`
+///        and be constructible from nullptr, for the stub node
+/// @note enqueue is wait-free: one exchange and one store. A node is never touched by the queue once dequeued,
+///       so it can be reused or freed right away
 template<class T>
 class LockLessQ {
  public:
-  LockLessQ() : head_(nullptr), tail_(nullptr), size_(0) {}
+  LockLessQ() : stub_(nullptr), tail_(&stub_), head_(&stub_), size_(0) {}
 
   LockLessQ(LockLessQ &) = delete;
   LockLessQ(LockLessQ &&) = delete;
@@ -16,45 +23,149 @@ class LockLessQ {
   }
 
   void enqueue(T *elem) {
-	elem->next_ = nullptr;
-	T *pred = tail_.exchange(pred);
-	++size_;
+	size_.fetch_add(1, std::memory_order_relaxed);
+	push(elem);
+  }
 
-	if (pred == nullptr) {
-	  head_ = elem;
-	  return;
+  /// @note Must only be called from the single consumer
+  /// @returns the oldest node, or nullptr if empty or if the producer of the next node is still linking it in
+  T *dequeue() {
+	T *head = head_.load(std::memory_order_relaxed);
+	T *next = head->next_.load(std::memory_order_acquire);
+	if (head == &stub_) {
+	  if (next == nullptr) {
+		return nullptr;
+	  }
+	  head_.store(next, std::memory_order_relaxed);
+	  head = next;
+	  next = next->next_.load(std::memory_order_acquire);
 	}
-	pred->next_.store(elem);
+	if (next == nullptr) {
+	  if (head != tail_.load(std::memory_order_acquire)) {
+		return nullptr;// A producer has swung tail_ but not linked its node yet
+	  }
+	  // `head` is the last node; put the stub behind it so it can be handed out
+	  push(&stub_);
+	  next = head->next_.load(std::memory_order_acquire);
+	  if (next == nullptr) {
+		return nullptr;
+	  }
+	}
+	head_.store(next, std::memory_order_relaxed);
+	size_.fetch_sub(1, std::memory_order_relaxed);
+	return head;
   }
 
-  T *dequeue() {
-	if (head_ == nullptr) {
-	  return nullptr;
+  [[maybe_unused]] std::size_t approx_size() const { return size_.load(std::memory_order_relaxed); }
+
+  /// @note Consumer only; may return nullptr while is_empty() is false, like dequeue
+  [[maybe_unused]] T *peek() {
+	T *head = head_.load(std::memory_order_relaxed);
+	return (head == &stub_) ? head->next_.load(std::memory_order_acquire) : head;
+  }
+
+  /// @note Safe from any thread; approximate while producers or the consumer are at work
+  [[maybe_unused]] bool is_empty() const { return approx_size() == 0; }
+
+ private:
+  void push(T *elem) {
+	elem->next_.store(nullptr, std::memory_order_relaxed);
+	T *prev = tail_.exchange(elem, std::memory_order_acq_rel);
+	prev->next_.store(elem, std::memory_order_release);
+  }
+
+  T stub_;
+  alignas(64) std::atomic<T *> tail_;// Producers' end
+  alignas(64) std::atomic<T *> head_;// Consumer's end; atomic only so that peek() and is_empty() can't tear
+  std::atomic<std::size_t> size_;
+};
+
+/// @brief Bounded multi-producer, multi-consumer queue of values (Vyukov), for when nodes are not wanted at all
+/// @note Never blocks: enqueue fails when full and dequeue when empty
+template<class T>
+class BoundedLockLessQ {
+ public:
+  /// @param capacity: rounded up to a power of two
+  explicit BoundedLockLessQ(std::size_t capacity)
+	  : mask_(roundUpPow2(capacity) - 1), cells_(new Cell[mask_ + 1]), enqueuePos_(0), dequeuePos_(0) {
+	for (std::size_t i = 0; i <= mask_; ++i) {
+	  cells_[i].sequence_.store(i, std::memory_order_relaxed);
 	}
-	--size_;
+  }
 
-	T *elem = head_;
-	T *node = head_;
+  BoundedLockLessQ(BoundedLockLessQ &) = delete;
+  BoundedLockLessQ(BoundedLockLessQ &&) = delete;
 
-	head_ = nullptr;
+  /// @returns false if the queue is full
+  bool enqueue(const T &value) {
+	auto pos = enqueuePos_.load(std::memory_order_relaxed);
+	Cell *cell;
+	while (true) {
+	  cell = &cells_[pos & mask_];
+	  const auto diff = (intptr_t)cell->sequence_.load(std::memory_order_acquire) - (intptr_t)pos;
+	  if (diff == 0) {
+		if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+		  break;
+		}
+	  } else if (diff < 0) {
+		return false;// The cell still holds the value of the previous lap
+	  } else {
+		pos = enqueuePos_.load(std::memory_order_relaxed);
+	  }
+	}
+	cell->value_ = value;
+	cell->sequence_.store(pos + 1, std::memory_order_release);
+	return true;
+  }
 
-	if (!tail_.compare_exchange_strong(node, nullptr, std::memory_order_seq_cst, std::memory_order_seq_cst)) {
-	  while ((node = elem->next_.load()) == nullptr)
-		;
-	  head_ = node;
+  /// @returns false if the queue is empty
+  bool dequeue(T &value) {
+	auto pos = dequeuePos_.load(std::memory_order_relaxed);
+	Cell *cell;
+	while (true) {
+	  cell = &cells_[pos & mask_];
+	  const auto diff = (intptr_t)cell->sequence_.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+	  if (diff == 0) {
+		if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+		  break;
+		}
+	  } else if (diff < 0) {
+		return false;// Nothing enqueued into the cell yet
+	  } else {
+		pos = dequeuePos_.load(std::memory_order_relaxed);
+	  }
 	}
-	elem->next_ = nullptr;
-	return elem;
+	value = cell->value_;
+	cell->sequence_.store(pos + mask_ + 1, std::memory_order_release);// Free for the next lap
+	return true;
   }
 
-  [[maybe_unused]] std::size_t approx_size() { return size_; }
+  [[maybe_unused]] std::size_t capacity() const { return mask_ + 1; }
 
-  [[maybe_unused]] T *peek() { return head_; }
+  [[maybe_unused]] std::size_t approx_size() const {
+	const auto enqueued = enqueuePos_.load(std::memory_order_relaxed);
+	const auto dequeued = dequeuePos_.load(std::memory_order_relaxed);
+	return (enqueued > dequeued) ? (enqueued - dequeued) : 0;
+  }
 
-  [[maybe_unused]] bool is_empty() { return head_ == nullptr; }
+  [[maybe_unused]] bool is_empty() const { return approx_size() == 0; }
 
  private:
-  T *head_;
-  std::atomic<T *> tail_;
-  std::atomic<std::size_t> size_;
+  struct Cell {
+	std::atomic<std::size_t> sequence_;// Lap and state of the cell
+	T value_;
+  };
+
+  static std::size_t roundUpPow2(std::size_t value) {
+	std::size_t pow2 = 2;
+	while (pow2 < value) {
+	  pow2 <<= 1;
+	}
+	return pow2;
+  }
+
+  const std::size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<std::size_t> enqueuePos_;
+  alignas(64) std::atomic<std::size_t> dequeuePos_;
 };
@@ -0,0 +1,276 @@
+#include "../../include/Base/Constructs.h"
+#include "../../include/Base/Pages.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+Slab::Slab(size_t volume, size_t size, size_t align, SlabBacking backing, int node)
+	: totalCount_(volume), size_(size), count_(0), index_(0), align_(align), prepared_(0), hint_(0),
+	  backing_(backing), mapSize_(0), committed_(0), node_(node) {
+  map((volume * size_) + GUARD_BYTES_COUNT, backing);
+  if (chunkHead_ == nullptr) {
+	std::cerr << __func__ << " [ERROR] chunkHead_ == nullptr" << std::endl;
+	totalCount_ = 0;// Behave as an always full slab
+  } else if (node_ != numaNodeAny_) {
+	bindNode();
+  }
+  inUse_.resize(base::roundUp(totalCount_, bitmapWordBits_) / bitmapWordBits_);
+  full_.resize(base::roundUp(inUse_.size(), bitmapWordBits_) / bitmapWordBits_);
+  prepared_ = (backing_ == SlabBacking::HEAP) ? totalCount_ : std::min(totalCount_, committed_ / size_);
+  guard_ = ((uint8_t *)chunkHead_ + (size_ * totalCount_));
+}
+
+void Slab::map(size_t bytes, SlabBacking backing) {
+  backing_ = backing;
+  switch (backing) {
+	case SlabBacking::HUGE_TLB:
+	  // Huge pages are taken from the pool at mmap time, so there is nothing to commit later
+	  mapSize_ = base::roundUp(bytes, base::hugePageSize());
+	  chunkHead_ = base::mapHugeTlbPages(mapSize_);
+	  if (chunkHead_ != nullptr) {
+		committed_ = mapSize_;
+		return;
+	  }
+	  return map(bytes, SlabBacking::HUGE_TRANSPARENT);
+	case SlabBacking::HUGE_TRANSPARENT:
+	  mapSize_ = base::roundUp(bytes, base::hugePageSize());
+	  chunkHead_ = base::reserveAlignedPages(mapSize_, base::hugePageSize());
+	  if (chunkHead_ != nullptr && base::adviseHugePages(chunkHead_, mapSize_)) {
+		return;
+	  }
+	  if (chunkHead_ != nullptr) {
+		base::unmapPages(chunkHead_, mapSize_);
+	  }
+	  return map(bytes, SlabBacking::RESERVED);
+	case SlabBacking::RESERVED:
+	  // Only address space for now; prepare() commits pages as the high-water mark advances
+	  mapSize_ = base::roundUp(bytes, base::pageSize());
+	  chunkHead_ = base::reservePages(mapSize_);
+	  return;
+	case SlabBacking::HEAP:
+	  if (align_ <= alignof(std::max_align_t)) {
+		chunkHead_ = calloc(1, bytes);
+		return;
+	  }
+	  bytes = base::roundUp(bytes, align_);// aligned_alloc wants a multiple of the alignment
+	  chunkHead_ = aligned_alloc(align_, bytes);
+	  if (chunkHead_ != nullptr) {
+		memset(chunkHead_, 0, bytes);
+	  }
+	  return;
+  }
+}
+
+void Slab::bindNode() {
+  auto begin = (uintptr_t)chunkHead_;
+  auto end = begin + ((backing_ == SlabBacking::HEAP) ? (totalCount_ * size_) : mapSize_);
+  if (backing_ == SlabBacking::HEAP) {
+	// The pages at either end may be shared with other heap blocks
+	begin = base::roundUp(begin, base::pageSize());
+	end &= ~(base::pageSize() - 1);
+  }
+  if (end > begin && !base::bindPagesToNode((void *)begin, end - begin, node_)) {
+	std::cerr << __func__ << " [ERROR] Unable to bind slab to node " << node_ << std::endl;
+	node_ = numaNodeAny_;
+  }
+}
+
+Slab::~Slab() {
+  if (chunkHead_) {
+	if (backing_ == SlabBacking::HEAP) {
+	  free(chunkHead_);
+	} else {
+	  base::unmapPages(chunkHead_, mapSize_);
+	}
+	chunkHead_ = nullptr;
+  }
+}
+
+bool Slab::prepare(size_t count) {
+  const auto target = std::min(totalCount_, std::max(index_ + count, prepared_ + (commitStepBytes_ / size_)));
+  if (backing_ != SlabBacking::HEAP) {
+	// Commit whole huge pages for THP, otherwise the kernel can only back them with regular pages
+	const auto step = (backing_ == SlabBacking::HUGE_TRANSPARENT) ? base::hugePageSize() : (size_t)commitStepBytes_;
+	const auto bytes = std::min(mapSize_, base::roundUp(target * size_, step));
+	if (bytes > committed_) {
+	  if (!base::commitPages((uint8_t *)chunkHead_ + committed_, bytes - committed_)) {
+		std::cerr << __func__ << " [ERROR] Unable to commit pages" << std::endl;
+		return false;
+	  }
+	  committed_ = bytes;
+	}
+	prepared_ = std::min(totalCount_, committed_ / size_);// Use every slot the committed pages cover
+  }
+  return prepared_ >= index_ + count;
+}
+
+void Slab::purge() {
+  base::purgePages(chunkHead_, committed_);
+  index_ = 0;// Every in-use bit is already clear; the pages stay committed
+  hint_ = 0;
+}
+
+bool Slab::validateSlab() const {
+  if (backing_ != SlabBacking::HEAP && committed_ < mapSize_) {
+	return true;// The guard bytes are not committed yet; an overflow into them faults right away
+  }
+  if (memcmp(guard_, gTestGuard, GUARD_BYTES_COUNT) != 0) {
+	std::cerr << __func__ << " Memory Corruption Detected (Overflow). Re-run with ASan recommended!"
+			  << std::endl;
+	return false;
+  }
+  return true;
+}
+
+ObjectPool::ObjectPool(size_t volume, size_t size, size_t align, const PoolConfig_t &config)
+	: config_(config) {
+  align_ = std::max(align, alignof(PointerNode));// A slot must be able to hold its own inbox node
+  if (config_.padded_) {
+	align_ = std::max<size_t>(align_, cacheLineBytes_);
+  }
+  totalCount_ = volume;
+  size_ = base::roundUp(std::max(size, sizeof(PointerNode)), align_);
+  count_ = 0;
+  auto &growth = config_.growth_;
+  if (growth.slabVolume_ == 0) {
+	growth.slabVolume_ = volume;
+  }
+  maxCount_ = (growth.maxVolume_ != 0) ? std::max(growth.maxVolume_, volume) : (volume * maxGrowthFactor_);
+  slabs_.emplace_back(std::make_unique<Slab_t>(volume, size_, align_, config_.backing_, slabNode()));
+  active_ = slabs_.front().get();
+}
+
+std::string ObjectPool::str() const {
+  std::ostringstream ss;
+  ss << " [ " << std::endl;
+  ss << "\ttotalCount_: " << totalCount_ << std::endl;
+  ss << "\tcount_: " << count_ << std::endl;
+  ss << "\tsize_: " << size_ << std::endl;
+  ss << "\talign_: " << align_ << std::endl;
+  ss << "\tslabs_: " << slabs_.size() << std::endl;
+  ss << "\tmaxCount_: " << maxCount_ << std::endl;
+  ss << "\tbackings: " << backings() << std::endl;
+  ss << "\tnodes: " << nodes() << std::endl;
+  ss << "\tzero: " << zeroPolicyName(config_.zero_) << std::endl;
+  ss << "]" << std::endl;
+  return ss.str();
+}
+
+std::string ObjectPool::backings() const {
+  std::string names;
+  for (const auto &slab : slabs_) {
+	const std::string name = slabBackingName(slab->backing_);
+	if (names.find(name) == std::string::npos) {
+	  names += (names.empty() ? "" : "+") + name;
+	}
+  }
+  return names;
+}
+
+std::string ObjectPool::nodes() const {
+  std::string names;
+  for (const auto &slab : slabs_) {
+	const auto name = (slab->node_ == numaNodeAny_) ? std::string("any") : std::to_string(slab->node_);
+	if (("+" + names + "+").find("+" + name + "+") == std::string::npos) {
+	  names += (names.empty() ? "" : "+") + name;
+	}
+  }
+  return names;
+}
+
+PoolStats_t ObjectPool::snapshot(int id) const {
+  PoolStats_t stats {};
+  stats.id_ = id;
+  stats.objectSize_ = size_;
+  stats.capacity_ = totalCount_;
+  stats.inUse_ = inUse();
+  stats.highWater_ = highWater_;
+  stats.slabCount_ = slabs_.size();
+  stats.allocCount_ = allocCount_;
+  stats.freeCount_ = freeCount_;
+  stats.overflowCount_ = overflowCount_;
+  return stats;
+}
+
+int ObjectPool::slabNode() const {
+  return config_.numaLocal_ ? base::currentNumaNode() : numaNodeAny_;
+}
+
+void ObjectPool::streamZero(void *ptr, size_t size) {
+#if defined(__SSE2__)
+  auto begin = (uintptr_t)ptr;
+  const auto end = begin + size;
+  const auto head = std::min(end, base::roundUp(begin, sizeof(__m128i)));
+  memset(ptr, 0, head - begin);
+  const auto zero = _mm_setzero_si128();
+  for (begin = head; begin + sizeof(__m128i) <= end; begin += sizeof(__m128i)) {
+	_mm_stream_si128((__m128i *)begin, zero);
+  }
+  memset((void *)begin, 0, end - begin);
+  _mm_sfence();
+#else
+  memset(ptr, 0, size);
+#endif
+}
+
+void *ObjectPool::acquireSlow() {
+  // The active slab is full; move to any other slab that still has room
+  for (auto &slab : slabs_) {
+	if (!slab->isFull()) {
+	  active_ = slab.get();
+	  return active_->acquire();
+	}
+  }
+  return nullptr;
+}
+
+size_t ObjectPool::acquireBatch(void **out, size_t count) {
+  size_t got = active_->acquireBatch(out, count);
+  for (auto itr = slabs_.begin(); got < count && itr != slabs_.end(); ++itr) {
+	if (!(*itr)->isFull()) {
+	  active_ = itr->get();
+	  got += active_->acquireBatch(out + got, count - got);
+	}
+  }
+  acquired(got);
+  return got;
+}
+
+Slab_t *ObjectPool::grow() {
+  if (!canGrow()) {
+	return nullptr;
+  }
+  const auto &growth = config_.growth_;
+  auto volume = (growth.mode_ == GrowthPolicy_t::GEOMETRIC) ? std::max<size_t>(totalCount_, growth.slabVolume_)
+															: growth.slabVolume_;
+  volume = std::min(volume, maxCount_ - totalCount_);
+  slabs_.emplace_back(std::make_unique<Slab_t>(volume, size_, align_, config_.backing_, slabNode()));
+  totalCount_ += volume;
+  active_ = slabs_.back().get();
+  return active_;
+}
+
+void ObjectPool::releaseSlab(const Slab_t *slab) {
+  if (slab == slabs_.front().get()) {
+	return;// The initial slab stays for the lifetime of the pool
+  }
+  detachSlab(slab);// Dropping it frees the memory
+}
+
+SlabPtr_t ObjectPool::detachSlab(const Slab_t *slab) {
+  auto itr = std::find_if(slabs_.begin(), slabs_.end(), [slab](const SlabPtr_t &s) { return s.get() == slab; });
+  if (itr == slabs_.end()) {
+	return nullptr;
+  }
+  auto detached = std::move(*itr);
+  slabs_.erase(itr);
+  totalCount_ -= detached->totalCount_;
+  if (active_ == slab) {
+	active_ = slabs_.empty() ? nullptr : slabs_.front().get();
+  }
+  return detached;
+}
+
+bool ObjectPool::validatePool() const {
+  return std::all_of(slabs_.begin(), slabs_.end(), [](const SlabPtr_t &slab) { return slab->validateSlab(); });
+}
@@ -0,0 +1,140 @@
+#include "../../include/Base/Pages.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace base {
+
+  size_t pageSize() {
+	static const size_t size = sysconf(_SC_PAGESIZE);
+	return size;
+  }
+
+  size_t hugePageSize() {
+	static const size_t size = []() -> size_t {
+	  std::ifstream meminfo("/proc/meminfo");
+	  std::string key;
+	  size_t value;
+	  while (meminfo >> key >> value) {
+		if (key == "Hugepagesize:") {
+		  return value * 1024;
+		}
+		meminfo.ignore(64, '\n');
+	  }
+	  return 2 * 1024 * 1024;
+	}();
+	return size;
+  }
+
+  bool transparentHugePagesEnabled() {
+	static const bool enabled = []() {
+	  std::ifstream sysfs("/sys/kernel/mm/transparent_hugepage/enabled");
+	  std::string modes;
+	  std::getline(sysfs, modes);
+	  return modes.find("[always]") != std::string::npos || modes.find("[madvise]") != std::string::npos;
+	}();
+	return enabled;
+  }
+
+  void *reservePages(size_t bytes) {
+	auto addr = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (addr == MAP_FAILED) ? nullptr : addr;
+  }
+
+  void *reserveAlignedPages(size_t bytes, size_t alignment) {
+	// Over-reserve by one alignment unit and trim both ends
+	auto raw = (uint8_t *)reservePages(bytes + alignment);
+	if (raw == nullptr) {
+	  return nullptr;
+	}
+	auto aligned = (uint8_t *)roundUp((uintptr_t)raw, alignment);
+	if (aligned > raw) {
+	  munmap(raw, aligned - raw);
+	}
+	const auto tail = (raw + bytes + alignment) - (aligned + bytes);
+	if (tail > 0) {
+	  munmap(aligned + bytes, tail);
+	}
+	return aligned;
+  }
+
+  void *mapHugeTlbPages(size_t bytes) {
+#ifdef MAP_HUGETLB
+	auto addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	return (addr == MAP_FAILED) ? nullptr : addr;
+#else
+	return nullptr;
+#endif
+  }
+
+  bool adviseHugePages(void *addr, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+	return transparentHugePagesEnabled() && madvise(addr, bytes, MADV_HUGEPAGE) == 0;
+#else
+	return false;
+#endif
+  }
+
+  bool commitPages(void *addr, size_t bytes) {
+	return mprotect(addr, bytes, PROT_READ | PROT_WRITE) == 0;
+  }
+
+  void purgePages(void *addr, size_t bytes) {
+#if defined(MEMPOOL_MADV_FREE) && defined(MADV_FREE)
+	// Cheaper, but the pages stay in RSS until the kernel is short of memory
+	if (madvise(addr, bytes, MADV_FREE) == 0 || errno != EINVAL) {
+	  return;
+	}
+#endif
+	madvise(addr, bytes, MADV_DONTNEED);// Kernels before 4.5 do not know MADV_FREE
+  }
+
+  size_t numaNodeCount() {
+	static const size_t count = []() -> size_t {
+	  // Ranges such as "0", "0-3" or "0-1,4-5"
+	  std::ifstream sysfs("/sys/devices/system/node/online");
+	  size_t nodes = 0, first, last;
+	  while (sysfs >> first) {
+		last = first;
+		if (sysfs.peek() == '-') {
+		  sysfs.ignore(1);
+		  sysfs >> last;
+		}
+		nodes += (last - first) + 1;
+		sysfs.ignore(1);
+	  }
+	  return std::max<size_t>(nodes, 1);
+	}();
+	return count;
+  }
+
+  int currentNumaNode() {
+	unsigned cpu = 0, node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+	  return 0;
+	}
+	return (int)node;
+  }
+
+  bool bindPagesToNode(void *addr, size_t bytes, int node) {
+	if (numaNodeCount() <= 1) {
+	  return true;
+	}
+	if (node < 0 || node >= (int)sizeof(unsigned long) * 8) {
+	  return false;
+	}
+	const unsigned long mask = 1UL << node;
+	// MPOL_PREFERRED rather than MPOL_BIND: a full node spills over instead of failing the fault
+	return syscall(SYS_mbind, addr, bytes, MPOL_PREFERRED, &mask, sizeof(mask) * 8, MPOL_MF_MOVE) == 0;
+  }
+
+  void unmapPages(void *addr, size_t bytes) {
+	munmap(addr, bytes);
+  }
+}// namespace base
@@ -1,5 +1,7 @@
 #include "../../include/Base/ThreadInfo.h"
 #include <sys/resource.h>
+#include <algorithm>
+#include <ctime>
 #include <syscall.h>
 #include <unistd.h>
 
@@ -9,7 +11,9 @@ namespace base {
 
   thread_local ThreadInfoPtr_t ThreadInfo::instance_ = nullptr;
 
-  ThreadInfo::ThreadInfo() : creationTime_(time(nullptr)), lastSysTime_(0), lastUsrTime_(0), tid_(GET_TID()) {
+  ThreadInfo::ThreadInfo()
+	  : samples_(), nextSample_(0), sampleCount_(0), occupancy_(0), lastSysTime_(0), lastUsrTime_(0),
+		creationTime_(time(nullptr)), tid_(GET_TID()) {
   }
 
   ThreadInfoPtr_t &ThreadInfo::getInstance() {
@@ -58,8 +62,31 @@ namespace base {
 	return diff;
   }
 
+  uint64_t ThreadInfo::getCpuTime() {
+	timespec now {};
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+	  return 0;
+	}
+	return (now.tv_sec * (uint64_t)1000000000) + now.tv_nsec;
+  }
+
   uint ThreadInfo::getOccupancy() {
-	/* I need to calculate this Thread's occupancy here */
-	return 0;
+	timespec now {};
+	clock_gettime(CLOCK_MONOTONIC, &now);// vDSO; the thread CPU clock is a real syscall so it is read less often
+	const auto wallNs = (now.tv_sec * (uint64_t)1000000000) + now.tv_nsec;
+	const auto &newest = samples_[(nextSample_ + occupancyWindowSlots_ - 1) % occupancyWindowSlots_];
+	if (sampleCount_ != 0 && (wallNs - newest.wallNs_) < occupancySampleNs_) {
+	  return occupancy_;
+	}
+	const OccupancySample_t sample {wallNs, getCpuTime()};
+	const auto &oldest = samples_[(sampleCount_ < occupancyWindowSlots_) ? 0 : nextSample_];
+	if (sampleCount_ != 0 && sample.wallNs_ > oldest.wallNs_) {
+	  const auto busy = ((sample.cpuNs_ - oldest.cpuNs_) * 100) / (sample.wallNs_ - oldest.wallNs_);
+	  occupancy_ = (uint)std::min<uint64_t>(busy, 100);
+	}
+	samples_[nextSample_] = sample;
+	nextSample_ = (nextSample_ + 1) % occupancyWindowSlots_;
+	sampleCount_ = std::min<size_t>(sampleCount_ + 1, occupancyWindowSlots_);
+	return occupancy_;
   }
 }// namespace base
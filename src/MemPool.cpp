@@ -1,31 +1,116 @@
 #include "../include/MemPool.h"
+#include "../include/Base/Pages.h"
 #include "../include/Base/ThreadInfo.h"
+#include <fstream>
+#include <map>
+#include <semaphore.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 thread_local MemPoolPtr_t MemPool::instance_ = nullptr;
-std::atomic<bool> MemPool::houseKeepingInProg_ = false;
-PtrsCache_t MemPool::sharedBuffer_;
-SpinLock MemPool::sharedBufferLock_{};
-SpinLock MemPool::houseKeepingLock_{};
+std::vector<MemPool *> MemPool::registry_;
+SpinLock MemPool::registryLock_{"RegistryLock"};
+ChunkTable_t MemPool::globalChunks_;
+std::atomic<const ChunkTable_t *> MemPool::chunkSnapshot_ {nullptr};
+ReadEpoch MemPool::chunksEpoch_;
+SlabVec_t MemPool::orphanSlabs_;
+SpinLock MemPool::globalChunksLock_{"GlobalChunksLock"};
+#if MEMPOOL_TRACK_OVERFLOW
+std::unordered_set<void *> MemPool::overflowBlocks_;
+SpinLock MemPool::overflowLock_{"OverflowLock"};
+#endif
+
+namespace {
+  SpinLock reclaimerLock;// Serializes starting and stopping
+  std::atomic<bool> reclaimerRunning {false};
+
+  /// @brief Stops the reclaimer at exit, before the registry it walks goes away
+  struct Reclaimer {
+	std::thread thread_;
+
+	/// @returns false if it was not running
+	bool stop() {
+	  reclaimerLock.lock();
+	  reclaimerRunning = false;
+	  const bool running = thread_.joinable();
+	  if (running) {
+		thread_.join();
+	  }
+	  reclaimerLock.unlock();
+	  return running;
+	}
 
-MemPoolPtr_t &MemPool::getInstance() {
-  static thread_local std::once_flag flag;
+	~Reclaimer() { stop(); }
+  } reclaimer;
+}// namespace
+
+MemPoolPtr_t &MemPool::createInstance() {
+  static thread_local std::once_flag flag;// Not again while the thread exits
   std::call_once(flag, [&]() { instance_.reset(new MemPool()); });
   return instance_;
 }
 
 MemPool::MemPool()
-	: volume_(defaultVolume_), myTid_(current->getTid()),
-	  houseKeepingCount_(0), houseKeepingDeferCount_(0),
-	  mandatoryHouseKeepingCount_(0), freeMemoryBlocks_(0),
-	  returnedFreeMemoryBlocks_(0), currPool_(nullptr),
-	  objectMap_(std::make_shared<ObjectMap_t>()),
-	  getBufCount_(0), retBufCount_(0) {
+	: objectMap_(std::make_shared<ObjectMap_t>()), sizeClassPools_(sizeClassCount_), sizeClassMode_(false),
+	  config_({{GrowthPolicy_t::GEOMETRIC, 0, 0}, SlabBacking::HEAP}), pendingTrim_(false), trimCursor_(0),
+	  deferSkips_(0), houseKeepingEntries_(houseKeepingSlice_), houseKeepingMicros_(houseKeepingBudgetUs_),
+	  reclaimedPending_(false), volume_(defaultVolume_), getBufCount_(0), retBufCount_(0),
+	  myTid_(current->getTid()), houseKeepingCount_(0), houseKeepingDeferCount_(0),
+	  mandatoryHouseKeepingCount_(0), houseKeepingNs_(0), occupancy_(0), freeMemoryBlocks_(0),
+	  returnedFreeMemoryBlocks_(0), slabGrowCount_(0), slabReleaseCount_(0), slabPurgeCount_(0), reclaimedCount_(0),
+	  currPool_(nullptr) {
   if (objectMap_ == nullptr) {
 	std::cerr << __func__ << " [ERROR] objectMap_ == nullptr" << std::endl;
   }
+  registryLock_.lock();
+  registry_.push_back(this);
+  registryLock_.unlock();
 }
 
 MemPool::~MemPool() {
+  // Out of the registry first, so no walker looks at us while we tear down
+  registryLock_.lock();
+  registry_.erase(std::remove(registry_.begin(), registry_.end(), this), registry_.end());
+  registryLock_.unlock();
+  typePools_.clear();
+  globalChunksLock_.lock();
+  // Foreign frees find us through the snapshot; once none of them can see us there, the inbox is all there will ever be.
+  // Until we unlock, frees into our slabs wait for the lock and then see them as orphans
+  for (auto &chunk : globalChunks_) {
+	if (chunk.owner_ == this) {
+	  chunk.owner_ = nullptr;
+	}
+  }
+  publishChunks();
+  while (auto node = inbox_.dequeue()) {
+	const auto ptr = node->ptr_;
+	const auto chunk = findChunk(chunks_, ptr);
+	if (chunk != nullptr) {
+	  doCleanup(chunk->pool_, chunk->slab_, chunk->slab_->indexOf(ptr));
+	}
+  }
+  // Out of the registry, so the reclaimer is done with us as well
+  flushReclaimed(std::chrono::steady_clock::time_point::max());
+  // Slabs with buffers still held by other threads outlive us; the last returnBuffer into one of them frees it
+  for (auto &chunk : globalChunks_) {
+	if (chunk.owner_ != nullptr || chunk.pool_ == nullptr) {
+	  continue;// Not ours: live, or orphaned already by another exited thread
+	}
+	if (chunk.slab_->count_ != 0) {
+	  orphanSlabs_.push_back(chunk.pool_->detachSlab(chunk.slab_));
+	} else {
+	  chunk.slab_ = nullptr;// Goes away with its pool
+	}
+	chunk.pool_ = nullptr;
+  }
+  globalChunks_.erase(std::remove_if(globalChunks_.begin(), globalChunks_.end(),
+									 [](const ChunkRange_t &chunk) { return chunk.slab_ == nullptr; }),
+					  globalChunks_.end());
+  publishChunks();
+  globalChunksLock_.unlock();
+  chunks_.clear();
+  sizeClassPools_.clear();
   objectMap_->clear();
   objectMap_ = nullptr;
 }
@@ -36,22 +121,38 @@ bool MemPool::doHouseKeepingIfAllowed() {
   std::cout << stats << std::endl;
 #endif
 
+  // With the reclaimer running our inbox is its job, unless we are about to run out
+  const bool settleInbox = !inbox_.is_empty() && (!isReclaimerRunning() || isUpperThresholdMet());
+  if (!settleInbox && !isTrimDue()) {
+	return false;// Nothing has been returned to us by other threads and nothing to give back
+  }
   if (isUpperThresholdMet()) {
-	// This means that this memory pool is at 95% capacity; but the Thread is less than 88% Occupancy
-	// we need to do housekeeping to ensure proper working; we'll spin & block
-	houseKeepingLock_.lock();
-
+	// This means that this memory pool is at 95% capacity; we need to reclaim regardless of the thread's load
+	occupancy_ = current->getOccupancy();
 	mandatoryHouseKeepingCount_++;
-  } else if (houseKeepingInProg_ || !houseKeepingLock_.trylock()) {
-	// We'll try to lock this flag without spinning; if we don't get lock someone else is doing housekeeping
-	++houseKeepingDeferCount_;
-	return false;
+  } else {
+	// Deferred already: the occupancy can't change before its next sample, and even the clock is not free
+	if (deferSkips_ != 0) {
+	  --deferSkips_;
+	  return false;
+	}
+	const auto now = std::chrono::steady_clock::now();
+	if (now < deferredUntil_) {
+	  deferSkips_ = houseKeepingDeferStride_;
+	  return false;
+	}
+	occupancy_ = current->getOccupancy();
+	if (occupancy_ >= threadOccupancyThreshold_) {
+	  // Thread is busy and the pool still has head-room; this can wait
+	  ++houseKeepingDeferCount_;
+	  deferredUntil_ = now + std::chrono::nanoseconds(occupancySampleNs_);
+	  return false;
+	}
   }
-  houseKeepingInProg_ = true;
+  const auto start = std::chrono::steady_clock::now();
   doHouseKeeping();
+  houseKeepingNs_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
   houseKeepingCount_++;
-  houseKeepingLock_.unlock();
-  houseKeepingInProg_ = false;
   return true;
 }
 
@@ -60,94 +161,310 @@ void MemPool::setPerObjectCount(size_t _volume) {
 }
 
 bool MemPool::registerNewObject(int _id, size_t _size) {
+  return registerNewObject(_id, _size, defaultSlotAlign_, config_);
+}
+
+bool MemPool::registerNewObject(int _id, size_t _size, size_t _align) {
+  return registerNewObject(_id, _size, _align, config_);
+}
+
+bool MemPool::registerNewObject(int _id, size_t _size, const PoolConfig_t &_config) {
+  return registerNewObject(_id, _size, defaultSlotAlign_, _config);
+}
+
+bool MemPool::registerNewObject(int _id, size_t _size, size_t _align, const PoolConfig_t &_config) {
   const auto &itr = objectMap_->find(_id);
   if (itr != objectMap_->end()) {
 	std::cout << __func__ << " [INFO] Key already Registered!" << std::endl;
 	return false;
   }
+  if (_align == 0 || (_align & (_align - 1)) != 0 || _align > base::pageSize()) {
+	std::cerr << __func__ << " [ERROR] Alignment must be a power of two up to the page size: " << _align << std::endl;
+	return false;
+  }
+
+  // Size class slots are only as aligned as their 16 byte steps
+  if (sizeClassMode_ && _size <= sizeClassMax_ && _align <= sizeClassSmallStep_ && !_config.padded_) {
+	const auto &pool = getSizeClassPool(_size);
+	poolsLock_.lock();
+	objectMap_->emplace(_id, pool);// Share the pool with everything of a similar size
+	poolsLock_.unlock();
+	++registeredCount_;
+	return true;
+  }
 
-  auto pool = std::make_shared<ObjectPool_t>(volume_, _size);// create a new Pool of Objects
+  auto pool = std::make_shared<ObjectPool_t>(volume_, _size, _align, _config);// create a new Pool of Objects
+  addPool(pool);
+  poolsLock_.lock();
   objectMap_->emplace(_id, std::move(pool));
+  poolsLock_.unlock();
+  ++registeredCount_;
   return true;
 }
 
+void MemPool::addPool(const ObjectPoolPtr_t &pool) {
+  for (const auto &slab : pool->slabs_) {
+	addChunk(pool.get(), slab.get());
+  }
+}
+
+void MemPool::addChunk(ObjectPool_t *pool, Slab_t *slab) {
+  const ChunkRange_t chunk {(uintptr_t)slab->chunkHead_, slab->chunkEnd(), pool, slab, this};
+  insertChunk(chunks_, chunk);
+  globalChunksLock_.lock();
+  insertChunk(globalChunks_, chunk);
+  publishChunks();
+  globalChunksLock_.unlock();
+}
+
+void MemPool::removeChunk(const Slab_t *slab) {
+  const auto isSlab = [slab](const ChunkRange_t &chunk) { return chunk.slab_ == slab; };
+  chunks_.erase(std::remove_if(chunks_.begin(), chunks_.end(), isSlab), chunks_.end());
+  globalChunksLock_.lock();
+  globalChunks_.erase(std::remove_if(globalChunks_.begin(), globalChunks_.end(), isSlab), globalChunks_.end());
+  publishChunks();
+  globalChunksLock_.unlock();
+}
+
+void MemPool::publishChunks() {
+  const auto stale = chunkSnapshot_.exchange(new ChunkTable_t(globalChunks_), std::memory_order_seq_cst);
+  chunksEpoch_.synchronize();
+  delete stale;
+}
+
+bool MemPool::growPool(ObjectPool_t *pool) {
+  poolsLock_.lock();
+  auto slab = pool->grow();
+  poolsLock_.unlock();
+  if (slab == nullptr) {
+	return false;
+  }
+  addChunk(pool, slab);
+  ++slabGrowCount_;
+  return true;
+}
+
+void MemPool::trimPools(std::chrono::steady_clock::time_point _deadline) {
+  if (trimCursor_ == 0) {
+	pendingTrim_ = false;// Slabs emptied from here on ask for the next pass
+  }
+  size_t position = 0;
+  const auto trimNext = [&](ObjectPool_t *pool) {
+	if (position++ < trimCursor_) {
+	  return true;// Done before the last interruption
+	}
+	trimPool(pool);
+	++trimCursor_;
+	return std::chrono::steady_clock::now() < _deadline;
+  };
+  for (const auto &node : *objectMap_) {
+	if (!trimNext(node.second.get())) {
+	  return;
+	}
+  }
+  for (const auto &pool : sizeClassPools_) {
+	if (pool && !trimNext(pool.get())) {
+	  return;
+	}
+  }
+  trimCursor_ = 0;
+}
+
+void MemPool::trimPool(ObjectPool_t *pool) {
+  flushReclaimed(pool, std::chrono::steady_clock::time_point::max());// Slots in there keep their slabs busy
+  for (size_t i = pool->slabs_.size(); i > 1; --i) {
+	const auto slab = pool->slabs_[i - 1].get();
+	if (pool->isReleasable(slab, lowerThreshold_)) {
+	  // Nothing in this slab is dispatched or pending in our inbox, so nobody can look it up anymore
+	  removeChunk(slab);
+	  poolsLock_.lock();
+	  pool->releaseSlab(slab);
+	  poolsLock_.unlock();
+	  ++slabReleaseCount_;
+	}
+  }
+  for (const auto &slab : pool->slabs_) {
+	if (slab->isPurgeable()) {
+	  slab->purge();
+	  ++slabPurgeCount_;
+	}
+  }
+}
+
+const ObjectPoolPtr_t &MemPool::getSizeClassPool(size_t _size) {
+  const auto index = sizeClassIndex(_size);
+  auto &pool = sizeClassPools_[index];
+  if (pool == nullptr) {
+	const auto size = sizeClassSize(index);
+	const auto volume = std::max<size_t>(sizeClassMinVolume_, sizeClassChunkBytes_ / size);
+	auto config = config_;
+	if (config.zero_ == ZeroPolicy::NONE) {
+	  config.zero_ = ZeroPolicy::ON_ALLOC;// allocate() hands out zeroed memory
+	}
+	config.padded_ = false;// A size class is a slot size; padding it would turn it into another one
+	auto created = std::make_shared<ObjectPool_t>(volume, size, sizeClassSmallStep_, config);
+	addPool(created);
+	poolsLock_.lock();
+	pool = std::move(created);
+	poolsLock_.unlock();
+  }
+  return pool;
+}
+
+bool MemPool::isSizeClassPool(const ObjectPool_t *pool) const {
+  const auto index = sizeClassIndex(pool->size_);
+  return (index < sizeClassCount_) && (sizeClassPools_[index].get() == pool);
+}
+
+const ChunkRange_t *MemPool::findChunk(const ChunkTable_t &table, const void *_ptr) {
+  const auto addr = (uintptr_t)_ptr;
+  auto itr = std::upper_bound(table.begin(), table.end(), addr,
+							  [](uintptr_t lhs, const ChunkRange_t &rhs) { return lhs < rhs.begin_; });
+  if (itr == table.begin()) {
+	return nullptr;
+  }
+  --itr;
+  return (addr < itr->end_) ? &*itr : nullptr;
+}
+
+void MemPool::insertChunk(ChunkTable_t &table, const ChunkRange_t &chunk) {
+  auto itr = std::upper_bound(table.begin(), table.end(), chunk.begin_,
+							  [](uintptr_t lhs, const ChunkRange_t &rhs) { return lhs < rhs.begin_; });
+  table.insert(itr, chunk);
+}
+
 bool MemPool::validatePools() const {
   bool sane = true;
   for (const auto &pool : *objectMap_) {
 	if (!pool.second->validatePool()) {
-	  std::cerr << __func__ << " [ERROR] Pool Sanity is compromised for Key: " << pool.first << std::endl;
+	  std::cerr << __func__ << " [ERROR] Pool Sanity is compromised for Key: " << (int)pool.first << std::endl;
+	  sane = false;
+	}
+  }
+  for (const auto &pool : sizeClassPools_) {
+	if (pool && !pool->validatePool()) {
+	  std::cerr << __func__ << " [ERROR] Pool Sanity is compromised for Size Class: " << pool->size_ << std::endl;
 	  sane = false;
 	}
   }
   return sane;
 }
 
-void* MemPool::getFromReturnBuffer() {
-  sharedBufferLock_.lock();
-  void *ptr = sharedBuffer_.front();
-  sharedBuffer_.pop_front();
-  sharedBufferLock_.unlock();
-  return ptr;
+void *MemPool::getBuffer(int _id) {
+#if MEMPOOL_LATENCY_HISTOGRAM
+  const LatencyTimer timer(&getLatency_);
+#endif
+  const auto &itr = objectMap_->find(_id);
+  if (itr == objectMap_->end()) {
+	std::cerr << __func__ << " [ERROR] Invalid Key Provided" << std::endl;
+	return nullptr;
+  }
+  return getBufferFrom(itr->second.get());
 }
 
-void MemPool::pushToReturnBuffer(void *ptr) {
-  sharedBufferLock_.lock();
-  sharedBuffer_.push_back(ptr);
-  sharedBufferLock_.unlock();
+void *MemPool::allocate(size_t _size) {
+#if MEMPOOL_LATENCY_HISTOGRAM
+  const LatencyTimer timer(&getLatency_);
+#endif
+  if (_size > sizeClassMax_) {
+	++getBufCount_;
+	return getOverflowBlock(_size);
+  }
+  return getBufferFrom(getSizeClassPool(_size).get());
 }
 
-size_t MemPool::getReturnBufferSize() {
-  sharedBufferLock_.lock();
-  auto size = sharedBuffer_.size();
-  sharedBufferLock_.unlock();
-  return size;
+size_t MemPool::nextTypeSlot() {
+  static std::atomic<size_t> slots {0};
+  return slots++;
 }
 
-void *MemPool::getBuffer(int _id) {
-  ++getBufCount_;
+void MemPool::bindTypeSlot(size_t _slot, int _id) {
   const auto &itr = objectMap_->find(_id);
   if (itr == objectMap_->end()) {
-	std::cerr << __func__ << " [ERROR] Invalid Key Provided" << std::endl;
+	return;
+  }
+  if (_slot >= typePools_.size()) {
+	typePools_.resize(_slot + 1, nullptr);
+  }
+  typePools_[_slot] = itr->second.get();
+}
+
+ObjectPool_t *MemPool::registerRawSlot(size_t _slot, int _id, int _typeId, size_t _size, size_t _align) {
+  if (objectMap_->find(_id) == objectMap_->end()) {
+	auto config = config_;
+	auto align = _align;
+	const auto &typed = objectMap_->find(_typeId);
+	if (typed != objectMap_->end()) {
+	  config = typed->second->config_;// Say, registerType<T>() with a stricter alignment or padded slots
+	  align = std::max(align, typed->second->align_);
+	}
+	config.zero_ = ZeroPolicy::NONE;// Every object is constructed over its slot; zeroing it is wasted work
+	registerNewObject(_id, _size, align, config);
+  }
+  return registerTypeSlot(_slot, _id, _size, _align);
+}
+
+ObjectPool_t *MemPool::registerTypeSlot(size_t _slot, int _id, size_t _size, size_t _align) {
+  if (objectMap_->find(_id) == objectMap_->end()) {
+	registerNewObject(_id, _size, _align, config_);
   }
-  currPool_ = itr->second;
-  // Only try houseKeeping if Current Threads Occupancy is less than 88%
-  if (isLowerThresholdMet() && (current->getOccupancy() < threadOccupancyThreshold_)) {
+  const auto &itr = objectMap_->find(_id);
+  if (itr == objectMap_->end()) {
+	std::cerr << __func__ << " [ERROR] Could not register a pool for type ID " << _id << std::endl;
+	return nullptr;
+  }
+  if (itr->second->size_ < _size || itr->second->align_ < _align) {
+	// Another type registered under the same ID, through registerNewObject() or a hash collision
+	std::cerr << __func__ << " [ERROR] Pool of type ID " << _id << " has " << itr->second->size_ << " byte slots aligned to "
+			  << itr->second->align_ << ", not enough for " << _size << " aligned to " << _align << std::endl;
+	return nullptr;
+  }
+  bindTypeSlot(_slot, _id);
+  return typePool(_slot);
+}
+
+void *MemPool::getBufferFrom(ObjectPool_t *pool, bool _zero) {
+  ++getBufCount_;
+  if (auto ptr = pool->reuse()) {
+	if (_zero) {
+	  pool->prepare(ptr, true);
+	}
+	if (__builtin_expect(isTrimDue(), 0)) {
+	  currPool_ = pool;// The reclaimer may have left more than we are going to hand out again
+	  doHouseKeepingIfAllowed();
+	  currPool_ = nullptr;
+	}
+	return ptr;// Settled by the reclaimer
+  }
+  currPool_ = pool;
+  if (isLowerThresholdMet() || isTrimDue()) {
 	// 60% pool is exhausted
 	doHouseKeepingIfAllowed();// we'll try to do this as soon as we reach 60% exhaustion; This can be deferred
 							  // till 95% exhaustion
   }
-  // We will start from the last index and move forward until we find a free memory block
-  auto index = currPool_->index_;
-  for (; index < currPool_->totalCount_ && currPool_->pool_->at(index)->inUse_; ++index)
-	;
-  // So either we found a free memory block or we are overshooting the max count
-  if (index >= currPool_->totalCount_) {// Overshoot case
+  // Reuse the lowest returned slot, or take the next never used one; add a slab if the policy allows before giving up
+  auto ptr = currPool_->acquire();
+  if (ptr == nullptr && growPool(currPool_)) {
+	ptr = currPool_->acquire();
+  }
+  if (ptr == nullptr) {// Overshoot case
 #if VERBOSE_DEBUG
 	std::ostringstream ss;
-	ss << "Index: " << index << " Lower Threshold:" << FromBoolToString(isLowerThresholdMet())
+	ss << "Lower Threshold:" << FromBoolToString(isLowerThresholdMet())
 	   << " Upper Threshold:" << FromBoolToString(isUpperThresholdMet())
-	   << " ObjectMap Info: " << itr->second.str();
+	   << " ObjectMap Info: " << pool->str();
 	std::cout << ss.str() << std::endl;
 #endif
-	// We are all out of Available memory
-	// We are going to allocate a new memory block
-	auto ptr = calloc(1, currPool_->size_);
-	if (ptr == nullptr) {
-	  std::cerr << __func__ << " [ERROR] No Free Memory available!" << std::endl;
-	}
-	// We need to keep track of this newly created memory so that once it's returned we can release it
-	dispatched_.emplace(ptr, std::make_pair(-1, -1));
-	++freeMemoryBlocks_;
+	// We are all out of Available memory and the pool may not grow any further
+	++currPool_->overflowCount_;
+	ptr = getOverflowBlock(currPool_->size_);
 	currPool_ = nullptr;
 	return ptr;
   }
 
-  // So `index` is within the limit, and we found an available slot
-  currPool_->index_ = index;                 // Update the Last Access Index
-  currPool_->pool_->at(index)->inUse_ = true;// This is inUse now
-  ++currPool_->count_;                       // Update the count of inUse Memory
-  const auto ptr = currPool_->pool_->at(index)->data_;
-  dispatched_.emplace(ptr, std::make_pair(index, _id));// Hash the pointer and save its index with _id
+  if (_zero) {
+	currPool_->prepare(ptr, false);
+  }
   if (currPool_ && !currPool_->validatePool()) {
 	abort();
   }
@@ -155,119 +472,591 @@ void *MemPool::getBuffer(int _id) {
   return ptr;
 }
 
-void MemPool::returnBuffer(void *_ptr) {
-  if (instance_ && (current->getTid() == instance_->myTid_)) {
-	++instance_->retBufCount_;
-	// I'm returning my own buffer
-	const auto &itr = instance_->dispatched_.find(_ptr);// Find the dispatched entry
-	if (itr == instance_->dispatched_.end()) {
-	  std::cerr << __func__ << " [ERROR] itr == instance_->dispatched_.end()" << std::endl;
-	}
+size_t MemPool::getBuffers(int _id, void **_out, size_t _count) {
+  const auto &itr = objectMap_->find(_id);
+  if (itr == objectMap_->end()) {
+	std::cerr << __func__ << " [ERROR] Invalid Key Provided" << std::endl;
+	return 0;
+  }
+  return getBuffersFrom(itr->second.get(), _out, _count);
+}
 
-	const auto index = itr->second.first;// Get the object Pool index
-	const auto key = itr->second.second; // Get the Object Map Key
+size_t MemPool::getBuffersFrom(ObjectPool_t *pool, void **_out, size_t _count) {
+  getBufCount_ += _count;
+  currPool_ = pool;
+  // Decide about housekeeping once, against the occupancy this batch is going to leave behind
+  if ((currPool_->count_ + _count) >= (currPool_->totalCount_ * lowerThreshold_)) {
+	doHouseKeepingIfAllowed();
+  }
+  size_t got = 0;
+  while (got < _count && (_out[got] = currPool_->reuse()) != nullptr) {
+	currPool_->prepare(_out[got++], true);
+  }
+  const auto reused = got;
+  got += currPool_->acquireBatch(_out + got, _count - got);
+  while (got < _count && growPool(currPool_)) {
+	got += currPool_->acquireBatch(_out + got, _count - got);
+  }
+  for (auto i = reused; i < got; ++i) {
+	currPool_->prepare(_out[i], false);
+  }
+  for (; got < _count; ++got) {
+	++currPool_->overflowCount_;
+	_out[got] = getOverflowBlock(currPool_->size_);
+  }
+  if (!currPool_->validatePool()) {
+	abort();
+  }
+  currPool_ = nullptr;
+  return got;
+}
 
-	if (index == -1 && key == -1) {// MemPool was out of Memory so we created new
-	  ++instance_->returnedFreeMemoryBlocks_;
-	  free(_ptr);
-	  return;
+void *MemPool::getOverflowBlock(size_t _size) {
+  // We are going to allocate a new memory block
+  auto ptr = calloc(1, _size);
+  if (ptr == nullptr) {
+	std::cerr << __func__ << " [ERROR] No Free Memory available!" << std::endl;
+	return nullptr;
+  }
+  // Overflow blocks are not inside any chunk, which is how returnBuffer tells them apart
+#if MEMPOOL_TRACK_OVERFLOW
+  overflowLock_.lock();
+  overflowBlocks_.emplace(ptr);
+  overflowLock_.unlock();
+#endif
+  ++freeMemoryBlocks_;
+  return ptr;
+}
+
+void MemPool::returnBuffers(void **_ptrs, size_t _count) {
+  const ChunkRange_t *chunk = nullptr;// Consecutive pointers mostly share a chunk; reuse the last lookup
+  for (size_t i = 0; i < _count; ++i) {
+	const auto ptr = _ptrs[i];
+	if (ptr == nullptr) {
+	  continue;
+	}
+	const auto addr = (uintptr_t)ptr;
+	if (instance_ && (chunk == nullptr || addr < chunk->begin_ || addr >= chunk->end_)) {
+	  chunk = findChunk(instance_->chunks_, ptr);
+	}
+	if (chunk != nullptr) {
+	  ++instance_->retBufCount_;
+	  instance_->doCleanup(chunk->pool_, chunk->slab_, chunk->slab_->indexOf(ptr));
+	} else {
+	  returnBufferSpecial(ptr);
 	}
+  }
+}
 
-	const auto &obj = instance_->objectMap_->find(key);
-	if (obj != instance_->objectMap_->end()) {
-	  instance_->doCleanup(obj->second, index);
+void MemPool::returnBuffer(void *_ptr) {
+  if (_ptr == nullptr) {
+	return;
+  }
+#if MEMPOOL_LATENCY_HISTOGRAM
+  const LatencyTimer timer(instance_ ? &instance_->returnLatency_ : nullptr);
+#endif
+  if (instance_) {
+	// Our own chunks are checked without any locking; anything else belongs to another thread or is an overflow block
+	const auto chunk = findChunk(instance_->chunks_, _ptr);
+	if (chunk != nullptr) {
+	  ++instance_->retBufCount_;
+	  instance_->doCleanup(chunk->pool_, chunk->slab_, chunk->slab_->indexOf(_ptr));
+	  return;
 	}
-  } else {
-	// We are not the owner of this memory; so lets transfer this pointer back to its owner thread
-	returnBufferSpecial(_ptr);
   }
+  returnBufferSpecial(_ptr);
 }
 
 void MemPool::returnBufferSpecial(void *_ptr) {
-  // this means that the thread that's returning thread is not the owner of this memory
-  // So now we need to somehow make this `_ptr` node empty and its control flag as false
+  // this means that the returning thread is not the owner of this memory
+  // A chunk is published before any of its slots is handed out, and taken out only once they are all back
+  const auto ticket = chunksEpoch_.enter();
+  const auto snapshot = chunkSnapshot_.load(std::memory_order_seq_cst);
+  const auto chunk = (snapshot != nullptr) ? findChunk(*snapshot, _ptr) : nullptr;
+  if (chunk == nullptr) {
+	chunksEpoch_.leave(ticket);
+	// Not inside any pool so it must be a calloc'ed overflow block; any thread can free those
+	releaseOverflowBlock(_ptr);
+	return;
+  }
+  if (chunk->owner_ != nullptr) {
+	// The owner waits for us to leave before it drains its inbox for the last time
+	chunk->owner_->inbox_.enqueue(new (_ptr) PointerNode(_ptr));// The freed slot becomes the queue node
+	chunksEpoch_.leave(ticket);
+	return;
+  }
+  chunksEpoch_.leave(ticket);// Publishing waits for us, so never take the lock as a reader
+  // The owner thread has exited, or is on its way out; the table under the lock has the last word
+  globalChunksLock_.lock();
+  const auto orphan = findChunk(globalChunks_, _ptr);
+  if (orphan != nullptr && orphan->owner_ != nullptr) {
+	orphan->owner_->inbox_.enqueue(new (_ptr) PointerNode(_ptr));// Can't exit while we hold the lock
+  } else if (orphan != nullptr) {
+	releaseOrphan(orphan, _ptr);
+  } else {
+	std::cerr << __func__ << " [ERROR] Double free of " << _ptr << " into a released orphaned slab" << std::endl;
+  }
+  globalChunksLock_.unlock();
+}
+
+bool MemPool::isPoolBuffer(const void *_ptr) {
+  if (instance_ && findChunk(instance_->chunks_, _ptr) != nullptr) {
+	return true;
+  }
+  const auto ticket = chunksEpoch_.enter();
+  const auto snapshot = chunkSnapshot_.load(std::memory_order_seq_cst);
+  const auto inChunk = (snapshot != nullptr) && (findChunk(*snapshot, _ptr) != nullptr);
+  chunksEpoch_.leave(ticket);
+  if (inChunk) {
+	return true;
+  }
+#if MEMPOOL_TRACK_OVERFLOW
+  overflowLock_.lock();
+  const auto overflow = overflowBlocks_.count(const_cast<void *>(_ptr)) != 0;
+  overflowLock_.unlock();
+  return overflow;
+#else
+  return false;
+#endif
+}
+
+void MemPool::releaseOrphan(const ChunkRange_t *chunk, void *_ptr) {
+  const auto slab = chunk->slab_;
+  const auto index = slab->indexOf(_ptr);
+  if (index >= slab->totalCount_ || !slab->release(index)) {
+	std::cerr << __func__ << " [ERROR] Invalid or double free of " << _ptr << " in an orphaned slab" << std::endl;
+	return;
+  }
+  if (slab->count_ == 0) {
+	// That was the last buffer out; nothing can reach this slab anymore
+	globalChunks_.erase(globalChunks_.begin() + (chunk - globalChunks_.data()));
+	orphanSlabs_.erase(std::find_if(orphanSlabs_.begin(), orphanSlabs_.end(),
+									[slab](const SlabPtr_t &orphan) { return orphan.get() == slab; }));
+	publishChunks();
+  }
+}
 
-  // we need to find the owner thread and make it use the returnBuffer(_ptr);
-  // this would be so easy if instead of having raw threads I had a threadPool
-  pushToReturnBuffer(_ptr);// We'll insert this ptr to static list; We'll iterate over this list periodically
-							   // from each thread and update dispatched_
+void MemPool::releaseOverflowBlock(void *_ptr) {
+#if MEMPOOL_TRACK_OVERFLOW
+  overflowLock_.lock();
+  const auto erased = overflowBlocks_.erase(_ptr);
+  overflowLock_.unlock();
+  if (erased == 0) {
+	std::cerr << __func__ << " [ERROR] " << _ptr << " was not dispatched by any MemPool" << std::endl;
+	return;
+  }
+#endif
+  if (instance_) {
+	++instance_->returnedFreeMemoryBlocks_;
+  }
+  free(_ptr);
 }
 
 void MemPool::doHouseKeeping() {
-  const auto size = getReturnBufferSize();
-  for (auto i = 0; i < size; ++i) {
-	if (current->getOccupancy() > threadOccupancyThreshold_) {// Premature Return if System is in Overload
-	  std::cerr << __func__ << "[ERROR] current->getOccupancy() > threadOccupancyThreshold_" << std::endl;
-	}
-	auto ptr = getFromReturnBuffer();
-	auto itr = dispatched_.find(ptr);
-	if (itr != dispatched_.end()) {
-	  // If this is in dispatched map with a valid key that means that we should be able to use RandomAccess
-	  // operator
-	  const auto &index = itr->second.first;
-	  const auto &key = itr->second.second;
-	  if (key == -1 && index == -1) {
-		// This key means that we were out of pre-allocated memory, and we just got new memory for use
-		free(ptr);
-		++returnedFreeMemoryBlocks_;
+  // Whatever the budget leaves over stays in the inbox, or at trimCursor_, for the next call
+  const auto deadline = (houseKeepingMicros_ == 0)
+	  ? std::chrono::steady_clock::time_point::max()
+	  : std::chrono::steady_clock::now() + std::chrono::microseconds(houseKeepingMicros_);
+  // If the reclaimer is at our inbox, only its reclaimed queues and the trim are left for us
+  if (inboxLock_.trylock()) {
+	auto pending = inbox_.approx_size();
+	if (houseKeepingEntries_ != 0) {
+	  pending = std::min(pending, houseKeepingEntries_);
+	}
+	for (size_t i = 0; i < pending; ++i) {
+	  if ((i + 1) % houseKeepingClockStride_ == 0 && std::chrono::steady_clock::now() >= deadline) {
+		inboxLock_.unlock();
+		return;
+	  }
+	  auto node = inbox_.dequeue();
+	  if (node == nullptr) {
+		break;
+	  }
+	  auto ptr = node->ptr_;
+	  const auto chunk = findChunk(chunks_, ptr);
+	  if (chunk != nullptr) {
+		doCleanup(chunk->pool_, chunk->slab_, chunk->slab_->indexOf(ptr));
 	  } else {
-		const auto &pool = objectMap_->find(key);
-		if (pool == objectMap_->end()) {
-		  // Highly unlikely scenario.
-		  // This means that the pointer is in my dispatched cache but I'm unable to find this pool in my
-		  // object map If this is the case we need to alert user but at the same time we need to release this
-		  // memory
-		  std::cerr << __func__ << " [ERROR] Unable to find " << key
-					<< " in the Object Pool for TID:" << current->getTid() << std::endl;
-		  free(ptr);
-		} else {
-		  doCleanup(pool->second, index);
-		}
+		// Only pointers inside our chunks are ever pushed to our inbox
+		std::cerr << __func__ << " [ERROR] Foreign pointer in the inbox of TID:" << myTid_ << std::endl;
+	  }
+	}
+	inboxLock_.unlock();
+  }
+  if (reclaimedPending_.exchange(false, std::memory_order_relaxed) && !flushReclaimed(deadline)) {
+	reclaimedPending_ = true;// Cut short by the budget
+	return;
+  }
+  if (isTrimDue() && (inbox_.is_empty() || isReclaimerRunning())) {
+	trimPools(deadline);
+  }
+}
+
+size_t MemPool::reclaimInbox() {
+  if (!inboxLock_.trylock()) {
+	return 0;// The owner is at it
+  }
+  void *ptrs[reclaimerBatch_];
+  size_t count = 0;
+  while (count < reclaimerBatch_) {
+	const auto node = inbox_.dequeue();
+	if (node == nullptr) {
+	  break;
+	}
+	ptrs[count++] = node->ptr_;
+  }
+  inboxLock_.unlock();
+  if (count == 0) {
+	return 0;
+  }
+  // Our chunks_ belong to the owner thread; the published snapshot has the same ranges.
+  // A slot in use pins its slab, so the pools found stay valid once we leave the epoch
+  ObjectPool_t *pools[reclaimerBatch_];
+  const auto ticket = chunksEpoch_.enter();
+  const auto snapshot = chunkSnapshot_.load(std::memory_order_seq_cst);
+  for (size_t i = 0; i < count; ++i) {
+	const auto chunk = (snapshot != nullptr) ? findChunk(*snapshot, ptrs[i]) : nullptr;
+	pools[i] = (chunk != nullptr) ? chunk->pool_ : nullptr;
+  }
+  chunksEpoch_.leave(ticket);
+  for (size_t i = 0; i < count; ++i) {
+	if (pools[i] != nullptr) {
+	  pools[i]->reclaim(ptrs[i]);
+	  if (pools[i]->reclaimed_.approx_size() > reclaimedBacklog_) {
+		reclaimedPending_ = true;// More than the owner seems to hand out again; it has to give them back
 	  }
-	  // Remove this from Dispatched Cache
-	  dispatched_.erase(itr);
 	} else {
-	  // If I did not dispatch this pointer I need to re-insert this into the list
-	  returnBufferSpecial(ptr);
+	  std::cerr << __func__ << " [ERROR] Foreign pointer in the inbox of TID:" << myTid_ << std::endl;
+	}
+  }
+  reclaimedCount_ += count;
+  return count;
+}
+
+bool MemPool::flushReclaimed(std::chrono::steady_clock::time_point _deadline) {
+  for (const auto &node : *objectMap_) {
+	if (!flushReclaimed(node.second.get(), _deadline)) {
+	  return false;
+	}
+  }
+  for (const auto &pool : sizeClassPools_) {
+	if (pool && !flushReclaimed(pool.get(), _deadline)) {
+	  return false;
 	}
   }
+  return true;
 }
 
-void MemPool::doCleanup(ObjectPoolPtr_t &obj, size_t index) {
-  memset(obj->pool_->at(index)->data_, 0, obj->size_);// Reset data
-  obj->pool_->at(index)->inUse_ = false;              // Set inUse flag to false
-  --obj->count_;                                      // Decrease the active Count
-  if (obj->index_ > index) {
-	obj->index_ = index;// Adjust the last Access Index
+bool MemPool::flushReclaimed(ObjectPool_t *pool, std::chrono::steady_clock::time_point _deadline) {
+  size_t flushed = 0;
+  while (auto node = pool->reclaimed_.dequeue()) {
+	const auto ptr = node->ptr_;
+	const auto chunk = findChunk(chunks_, ptr);
+	if (chunk != nullptr && chunk->pool_->restore(chunk->slab_, chunk->slab_->indexOf(ptr))) {
+	  checkIdle(chunk->pool_, chunk->slab_);
+	}
+	if (++flushed % houseKeepingClockStride_ == 0 && std::chrono::steady_clock::now() >= _deadline) {
+	  return false;
+	}
   }
+  return true;
+}
+
+bool MemPool::startReclaimer(uint64_t _idleMicros) {
+  reclaimerLock.lock();
+  if (reclaimerRunning) {
+	reclaimerLock.unlock();
+	return false;
+  }
+  reclaimerRunning = true;
+  reclaimer.thread_ = std::thread([_idleMicros]() {
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), reclaimerNice_);
+	while (reclaimerRunning) {
+	  size_t settled = 0;
+	  registryLock_.lock();
+	  for (auto pool : registry_) {
+		settled += pool->reclaimInbox();
+	  }
+	  registryLock_.unlock();
+	  if (settled == 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds(_idleMicros));
+	  }
+	}
+  });
+  reclaimerLock.unlock();
+  return true;
+}
+
+void MemPool::stopReclaimer() {
+  if (!reclaimer.stop()) {
+	return;
+  }
+  // What it settled goes back to the slabs: ours right away, that of every other thread at its next housekeeping
+  registryLock_.lock();
+  for (auto pool : registry_) {
+	pool->reclaimedPending_ = true;
+  }
+  registryLock_.unlock();
+  if (instance_) {
+	instance_->flushReclaimed(std::chrono::steady_clock::time_point::max());
+  }
+}
+
+bool MemPool::isReclaimerRunning() {
+  return reclaimerRunning.load(std::memory_order_relaxed);
+}
+
+void MemPool::doCleanup(ObjectPool_t *obj, Slab_t *slab, size_t index) {
+  if (index >= slab->totalCount_) {
+	std::cerr << __func__ << " [ERROR] Pointer does not point to the start of a slot" << std::endl;
+	return;
+  }
+  if (!obj->release(slab, index)) {// Reset data and clear its in-use bit
+	std::cerr << __func__ << " [ERROR] Double free detected at index: " << index << std::endl;
+	return;
+  }
+  checkIdle(obj, slab);
+}
+
+ThreadStats_t MemPool::threadStats() const {
+  ThreadStats_t stats {};
+  stats.tid_ = myTid_;
+  stats.poolCount_ = registeredCount_;
+  stats.getBufCount_ = getBufCount_;
+  stats.retBufCount_ = retBufCount_;
+  stats.overflowAllocCount_ = freeMemoryBlocks_;
+  stats.overflowFreeCount_ = returnedFreeMemoryBlocks_;
+  stats.houseKeepingCount_ = houseKeepingCount_;
+  stats.houseKeepingDeferCount_ = houseKeepingDeferCount_;
+  stats.mandatoryHouseKeepingCount_ = mandatoryHouseKeepingCount_;
+  stats.houseKeepingNs_ = houseKeepingNs_;
+  stats.slabGrowCount_ = slabGrowCount_;
+  stats.slabReleaseCount_ = slabReleaseCount_;
+  stats.slabPurgeCount_ = slabPurgeCount_;
+  stats.pendingRemoteReturns_ = inbox_.approx_size();
+  stats.reclaimedCount_ = reclaimedCount_;
+  stats.occupancy_ = occupancy_;
+#if MEMPOOL_LATENCY_HISTOGRAM
+  getLatency_.snapshot(stats.getLatency_);
+  returnLatency_.snapshot(stats.returnLatency_);
+#endif
+  return stats;
+}
+
+size_t MemPool::poolStats(PoolStats_t *_out, size_t _max) const {
+  size_t count = 0;
+  for (const auto &node : *objectMap_) {
+	if (!isSizeClassPool(node.second.get())) {// Shared pools are reported once below
+	  if (count < _max) {
+		_out[count] = node.second->snapshot((int)node.first);
+	  }
+	  ++count;
+	}
+  }
+  for (const auto &pool : sizeClassPools_) {
+	if (pool) {
+	  if (count < _max) {
+		_out[count] = pool->snapshot(-1);
+	  }
+	  ++count;
+	}
+  }
+  return count;
 }
 
 std::string MemPool::stats(bool detailed) const {
+  const auto thread = threadStats();
+  std::vector<PoolStats_t> pools(objectMap_->size() + sizeClassCount_);
+  pools.resize(poolStats(pools.data(), pools.size()));
+  size_t inUse = 0;
+  for (const auto &pool : pools) {
+	inUse += pool.inUse_;
+  }
   std::ostringstream ret;
   ret << " [ ";
-  ret << " GetBufferCount: " << this->getBufCount_ << "|"
-	  << " ReturnBufferCount: " << this->retBufCount_ << "|"
-	  << " ThreadID: " << this->myTid_ << "|"
-	  << " MemPool size: " << this->objectMap_->size() << "|"
-	  << " In Use: " << this->dispatched_.size() << "|"
-	  << " HouseKeeping Count: " << this->houseKeepingCount_ << "|"
-	  << " HouseKeeping Defer Count: " << this->houseKeepingDeferCount_ << "|"
-	  << " Mandatory HouseKeeping Count: " << this->mandatoryHouseKeepingCount_ << "|"
-	  << " Free Mem Count: " << this->freeMemoryBlocks_ << "|"
-	  << " Returned Free Mem Count: " << this->returnedFreeMemoryBlocks_ << "|"
-	  << " Gross Returned Mem Count: " << getReturnBufferSize();
+  ret << " GetBufferCount: " << thread.getBufCount_ << "|"
+	  << " ReturnBufferCount: " << thread.retBufCount_ << "|"
+	  << " ThreadID: " << thread.tid_ << "|"
+	  << " MemPool size: " << thread.poolCount_ << "|"
+	  << " In Use: " << inUse << "|"
+	  << " HouseKeeping Count: " << thread.houseKeepingCount_ << "|"
+	  << " HouseKeeping Defer Count: " << thread.houseKeepingDeferCount_ << "|"
+	  << " Mandatory HouseKeeping Count: " << thread.mandatoryHouseKeepingCount_ << "|"
+	  << " HouseKeeping Time (us): " << (thread.houseKeepingNs_ / 1000) << "|"
+	  << " Thread Occupancy: " << thread.occupancy_ << "%|"
+	  << " Free Mem Count: " << thread.overflowAllocCount_ << "|"
+	  << " Returned Free Mem Count: " << thread.overflowFreeCount_ << "|"
+	  << " Slab Grow Count: " << thread.slabGrowCount_ << "|"
+	  << " Slab Release Count: " << thread.slabReleaseCount_ << "|"
+	  << " Slab Purge Count: " << thread.slabPurgeCount_ << "|"
+	  << " Pending Remote Returns: " << thread.pendingRemoteReturns_ << "|"
+	  << " Reclaimed Count: " << thread.reclaimedCount_;
+#if MEMPOOL_LATENCY_HISTOGRAM
+  ret << "|"
+	  << " GetBuffer ns p50/p99/p999: " << thread.getLatency_.percentile(0.50) << "/"
+	  << thread.getLatency_.percentile(0.99) << "/" << thread.getLatency_.percentile(0.999) << "|"
+	  << " ReturnBuffer ns p50/p99/p999: " << thread.returnLatency_.percentile(0.50) << "/"
+	  << thread.returnLatency_.percentile(0.99) << "/" << thread.returnLatency_.percentile(0.999);
+#endif
 
   if (detailed) {
 	for (const auto &node : *this->objectMap_) {
 	  ret << " { ";
-	  ret << " Pool ID: " << node.first << "|"
-		  << " Pool Size: " << node.second->pool_->size() << "|"
-		  << " Pool InUse Count: " << node.second->count_ << "|"
+	  ret << " Pool ID: " << (int)node.first << "|"
+		  << " Pool Size: " << node.second->totalCount_ << "|"
+		  << " Slabs: " << node.second->slabs_.size() << "|"
+		  << " Backing: " << node.second->backings() << "|"
+		  << " Node: " << node.second->nodes() << "|"
+		  << " Pool InUse Count: " << node.second->inUse() << "|"
+		  << " High Water: " << node.second->highWater_ << "|"
+		  << " Overflow Count: " << node.second->overflowCount_ << "|"
 		  << " Pool Node Size: " << node.second->size_;
 	  ret << " } ";
 	}
+	for (const auto &pool : this->sizeClassPools_) {
+	  if (pool) {
+		ret << " { ";
+		ret << " Size Class: " << pool->size_ << "|"
+			<< " Pool Size: " << pool->totalCount_ << "|"
+			<< " Slabs: " << pool->slabs_.size() << "|"
+			<< " Backing: " << pool->backings() << "|"
+			<< " Node: " << pool->nodes() << "|"
+			<< " Pool InUse Count: " << pool->inUse() << "|"
+			<< " High Water: " << pool->highWater_ << "|"
+			<< " Overflow Count: " << pool->overflowCount_;
+		ret << " } ";
+	  }
+	}
   }
   ret << " ] \n\n";
 
   return ret.str();
 }
+
+void MemPool::forEachInstance(const std::function<void(const MemPool &)> &_visit) {
+  registryLock_.lock();
+  for (auto instance : registry_) {
+	instance->poolsLock_.lock();
+	_visit(*instance);
+	instance->poolsLock_.unlock();
+  }
+  registryLock_.unlock();
+}
+
+std::vector<TypeStats_t> MemPool::typeStats() {
+  std::map<std::pair<int, size_t>, TypeStats_t> types;
+  std::vector<PoolStats_t> pools;
+  forEachInstance([&](const MemPool &instance) {
+	pools.resize(instance.objectMap_->size() + sizeClassCount_);
+	pools.resize(instance.poolStats(pools.data(), pools.size()));
+	for (const auto &pool : pools) {
+	  auto &type = types[{pool.id_, pool.objectSize_}];
+	  type.id_ = pool.id_;
+	  type.objectSize_ = pool.objectSize_;
+	  ++type.threadCount_;
+	  type.capacity_ += pool.capacity_;
+	  type.inUse_ += pool.inUse_;
+	  type.highWater_ += pool.highWater_;
+	  type.allocCount_ += pool.allocCount_;
+	  type.freeCount_ += pool.freeCount_;
+	  type.overflowCount_ += pool.overflowCount_;
+	}
+  });
+  std::vector<TypeStats_t> result;
+  result.reserve(types.size());
+  for (const auto &type : types) {
+	result.push_back(type.second);
+  }
+  return result;
+}
+
+std::string MemPool::registryStats() {
+  std::ostringstream ret;
+  size_t instances = 0;
+  forEachInstance([&](const MemPool &instance) {
+	ret << instance.stats(true) << std::endl;
+	++instances;
+  });
+  size_t orphanInUse = 0;
+  globalChunksLock_.lock();
+  const auto orphans = orphanSlabs_.size();
+  for (const auto &slab : orphanSlabs_) {
+	orphanInUse += slab->count_;
+  }
+  globalChunksLock_.unlock();
+  ret << " [  Live MemPools: " << instances << "|"
+	  << " Orphaned Slabs: " << orphans << "|"
+	  << " Orphaned InUse Count: " << orphanInUse << " ]" << std::endl;
+  for (const auto lock : {&registryLock_, &globalChunksLock_}) {
+	const auto contention = lock->get_stats();
+	ret << " [  " << lock->get_name() << " Acquired: " << contention.acquireCount_ << "|"
+		<< " Contended: " << contention.contendedCount_ << "|"
+		<< " Spins: " << contention.spinCount_ << "|"
+		<< " Yields: " << contention.yieldCount_ << "|"
+		<< " Sleeps: " << contention.sleepCount_ << " ]" << std::endl;
+  }
+  for (const auto &type : typeStats()) {
+	ret << " { ";
+	if (type.id_ == -1) {
+	  ret << " Size Class: " << type.objectSize_ << "|";
+	} else {
+	  ret << " Pool ID: " << type.id_ << "|"
+		  << " Pool Node Size: " << type.objectSize_ << "|";
+	}
+	ret << " Threads: " << type.threadCount_ << "|"
+		<< " Pool Size: " << type.capacity_ << "|"
+		<< " InUse Count: " << type.inUse_ << "|"
+		<< " High Water: " << type.highWater_ << "|"
+		<< " Overflow Count: " << type.overflowCount_;
+	ret << " } " << std::endl;
+  }
+  return ret.str();
+}
+
+bool MemPool::dumpStats(const std::string &_path) {
+  std::ofstream out(_path, std::ios::trunc);
+  if (!out) {
+	std::cerr << __func__ << " [ERROR] Unable to open " << _path << std::endl;
+	return false;
+  }
+  out << registryStats();
+  return out.good();
+}
+
+namespace {
+  sem_t dumpRequest;// Posted by the signal handler; sem_post is async-signal-safe
+
+  void onDumpSignal(int) { sem_post(&dumpRequest); }
+}// namespace
+
+bool MemPool::enableStatsDumpOnSignal(const std::string &_path, int _signal) {
+  static std::atomic<bool> enabled {false};
+  if (enabled.exchange(true)) {
+	return false;
+  }
+  if (sem_init(&dumpRequest, 0, 0) != 0) {
+	std::cerr << __func__ << " [ERROR] Unable to create the dump semaphore" << std::endl;
+	enabled = false;
+	return false;
+  }
+  // Handler first: a signal that comes before the dumper runs stays posted, and a failure leaves no thread behind
+  struct sigaction action {};
+  action.sa_handler = onDumpSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  if (sigaction(_signal, &action, nullptr) != 0) {
+	std::cerr << __func__ << " [ERROR] Unable to install the handler for signal " << _signal << std::endl;
+	sem_destroy(&dumpRequest);
+	enabled = false;
+	return false;
+  }
+  // The dumper never calls MEM_POOL(), so it has no MemPool of its own and shows up in no dump
+  std::thread([_path]() {
+	while (true) {
+	  if (sem_wait(&dumpRequest) == 0) {
+		dumpStats(_path);
+	  }
+	}
+  }).detach();
+  return true;
+}
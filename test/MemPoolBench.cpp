@@ -0,0 +1,1033 @@
+#include "../include/MemPool.h"
+#include "../include/Memory/memory_resource.h"
+#include "../include/Memory/pool_allocator.h"
+#include "../include/Memory/shared_ptr.h"
+#include "../include/Memory/unique_ptr.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+  thread_local uint64_t gHeapAllocations = 0;// Counted by the operator new below
+}// namespace
+
+void *operator new(size_t size) {
+  ++gHeapAllocations;
+  if (auto ptr = malloc(size != 0 ? size : 1)) {
+	return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+  using Samples_t = std::vector<uint64_t>;
+
+  constexpr auto benchVolume_ = 100000;
+  constexpr auto benchObjectSize_ = 64;
+  constexpr auto benchIterations_ = 200000;
+  constexpr auto benchBurstObjects_ = 20000000;// Objects moved per burst-size run
+  constexpr auto benchStartupTypes_ = 20;       // Types each fresh thread registers
+  constexpr auto benchStartupObjectSize_ = 256;
+  constexpr auto benchStartupLive_ = 5000;      // Objects per type allocated after startup
+  constexpr auto benchTlbVolume_ = 1000000;     // Live objects touched at random by the page-size run
+  constexpr auto benchTlbObjectSize_ = 128;
+  constexpr size_t benchRemoteFrees_ = 60000; // Frees another thread piles into the inbox before the owner runs
+  constexpr auto benchIdleMs_ = 20;             // Owner pause between those frees and its next getBuffer
+
+  uint64_t percentile(Samples_t &samples, double pct) {
+	if (samples.empty()) {
+	  return 0;
+	}
+	const auto pos = static_cast<size_t>(pct * (samples.size() - 1));
+	std::nth_element(samples.begin(), samples.begin() + pos, samples.end());
+	return samples[pos];
+  }
+
+  uint64_t elapsedNs(Clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  }
+
+  /// @brief Bring a fresh pool to `occupancy`, fragment it and then measure steady-state getBuffer/returnBuffer
+  void benchOccupancy(int id, double occupancy) {
+	std::mt19937_64 rng(id);
+	MEM_POOL()->registerNewObject(id, benchObjectSize_);
+
+	const auto live = static_cast<size_t>(benchVolume_ * occupancy);
+	std::vector<void *> ptrs;
+	ptrs.reserve(live);
+	for (size_t i = 0; i < live; ++i) {
+	  ptrs.push_back(MEM_POOL()->getBuffer(id));
+	}
+	// Punch random holes and refill them so the free slots are scattered across the pool
+	std::shuffle(ptrs.begin(), ptrs.end(), rng);
+	for (size_t i = 0; i < live / 2; ++i) {
+	  MemPool::returnBuffer(ptrs[i]);
+	}
+	for (size_t i = 0; i < live / 2; ++i) {
+	  ptrs[i] = MEM_POOL()->getBuffer(id);
+	}
+
+	Samples_t getSamples, retSamples;
+	getSamples.reserve(benchIterations_);
+	retSamples.reserve(benchIterations_);
+	std::uniform_int_distribution<size_t> pick(0, live - 1);
+	for (auto i = 0; i < benchIterations_; ++i) {
+	  const auto victim = pick(rng);
+	  auto start = Clock::now();
+	  MemPool::returnBuffer(ptrs[victim]);
+	  retSamples.push_back(elapsedNs(start));
+
+	  start = Clock::now();
+	  ptrs[victim] = MEM_POOL()->getBuffer(id);
+	  getSamples.push_back(elapsedNs(start));
+	}
+
+	std::cout << std::setw(9) << static_cast<int>(occupancy * 100) << "%"
+			  << std::setw(14) << percentile(getSamples, 0.50)
+			  << std::setw(14) << percentile(getSamples, 0.99)
+			  << std::setw(14) << percentile(retSamples, 0.50)
+			  << std::setw(14) << percentile(retSamples, 0.99) << std::endl;
+
+	for (auto ptr : ptrs) {
+	  MemPool::returnBuffer(ptr);
+	}
+  }
+
+  void benchOccupancyLatency() {
+	std::cout << "getBuffer/returnBuffer latency (ns) by pool occupancy, "
+			  << benchVolume_ << " x " << benchObjectSize_ << "B slots" << std::endl;
+	std::cout << std::setw(10) << "occupancy" << std::setw(14) << "get p50" << std::setw(14) << "get p99"
+			  << std::setw(14) << "return p50" << std::setw(14) << "return p99" << std::endl;
+	MEM_POOL()->setPerObjectCount(benchVolume_);
+	benchOccupancy(1, 0.10);
+	benchOccupancy(2, 0.60);
+	benchOccupancy(3, 0.95);
+  }
+  double mopsPerSec(size_t ops, uint64_t ns) {
+	return (ops * 1000.0) / ns;
+  }
+
+  double mopsPerSec(size_t ops, Clock::time_point start) {
+	return mopsPerSec(ops, elapsedNs(start));
+  }
+
+  /// @brief Allocate and release bursts of `burst` objects, one call per object vs one call per burst
+  void benchBurst(int id, size_t burst) {
+	std::vector<void *> ptrs(burst);
+	const auto rounds = benchBurstObjects_ / burst;
+
+	auto start = Clock::now();
+	for (size_t r = 0; r < rounds; ++r) {
+	  for (size_t i = 0; i < burst; ++i) {
+		ptrs[i] = MEM_POOL()->getBuffer(id);
+	  }
+	  for (size_t i = 0; i < burst; ++i) {
+		MemPool::returnBuffer(ptrs[i]);
+	  }
+	}
+	const auto single = mopsPerSec(rounds * burst, start);
+
+	start = Clock::now();
+	for (size_t r = 0; r < rounds; ++r) {
+	  MEM_POOL()->getBuffers(id, ptrs.data(), burst);
+	  MemPool::returnBuffers(ptrs.data(), burst);
+	}
+	const auto batch = mopsPerSec(rounds * burst, start);
+
+	std::cout << std::setw(10) << burst << std::setw(16) << std::fixed << std::setprecision(1) << single
+			  << std::setw(16) << batch << std::setw(11) << std::setprecision(2) << (batch / single) << "x" << std::endl;
+  }
+
+  void benchBatchThroughput() {
+	std::cout << "getBuffer+returnBuffer throughput (Mobj/s), single calls vs batch calls" << std::endl;
+	std::cout << std::setw(10) << "burst" << std::setw(16) << "single" << std::setw(16) << "batch"
+			  << std::setw(12) << "speedup" << std::endl;
+	MEM_POOL()->setPerObjectCount(benchVolume_);
+	MEM_POOL()->registerNewObject(4, benchObjectSize_);
+	for (auto burst : {32, 64, 128, 256}) {
+	  benchBurst(4, burst);
+	}
+  }
+  size_t residentKiB() {
+	size_t pages = 0, resident = 0;
+	std::ifstream statm("/proc/self/statm");
+	statm >> pages >> resident;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+
+  /// @brief Register types on a fresh thread, use a few objects of each, release them and watch RSS
+  void benchStartup(SlabBacking backing, const char *name) {
+	std::thread([backing, name]() {
+	  const auto rssBefore = residentKiB();
+	  auto start = Clock::now();
+	  MEM_POOL()->setSlabBacking(backing);
+	  for (auto id = 0; id < benchStartupTypes_; ++id) {
+		MEM_POOL()->registerNewObject(id, benchStartupObjectSize_);
+	  }
+	  const auto startupUs = elapsedNs(start) / 1000;
+	  const auto rssRegistered = residentKiB();
+
+	  std::vector<void *> ptrs;
+	  for (auto id = 0; id < benchStartupTypes_; ++id) {
+		for (auto i = 0; i < benchStartupLive_; ++i) {
+		  ptrs.push_back(MEM_POOL()->getBuffer(id));
+		}
+	  }
+	  const auto rssUsed = residentKiB();
+	  // Once a pool runs empty the next getBuffer does housekeeping, which is where pages are handed back
+	  MemPool::returnBuffers(ptrs.data(), ptrs.size());
+	  for (auto id = 0; id < benchStartupTypes_; ++id) {
+		for (auto i = 0; i < 2; ++i) {
+		  MemPool::returnBuffer(MEM_POOL()->getBuffer(id));
+		}
+	  }
+	  const auto rssReleased = residentKiB();
+
+	  std::cout << std::setw(10) << name << std::setw(14) << startupUs
+				<< std::setw(14) << (rssRegistered - rssBefore)
+				<< std::setw(14) << (rssUsed - rssBefore)
+				<< std::setw(14) << (rssReleased - rssBefore) << std::endl;
+	}).join();
+  }
+
+  void benchStartupFootprint() {
+	std::cout << "Thread startup: register " << benchStartupTypes_ << " types x " << defaultVolume_ << " x "
+			  << benchStartupObjectSize_ << "B, use " << benchStartupLive_ << " of each, release them" << std::endl;
+	std::cout << std::setw(10) << "backing" << std::setw(14) << "startup us" << std::setw(14) << "RSS reg KiB"
+			  << std::setw(14) << "RSS used KiB" << std::setw(14) << "RSS freed KiB" << std::endl;
+	benchStartup(SlabBacking::HEAP, "heap");
+	benchStartup(SlabBacking::RESERVED, "reserved");
+  }
+
+  /// @brief Fill a pool with `backing`, then touch its objects in random order to expose dTLB misses
+  void benchPageSize(int id, SlabBacking backing) {
+	MEM_POOL()->setPerObjectCount(benchTlbVolume_);
+	MEM_POOL()->registerNewObject(id, benchTlbObjectSize_, {{GrowthPolicy_t::GEOMETRIC, 0, 0}, backing});
+	std::vector<uint64_t *> ptrs(benchTlbVolume_);
+	for (auto &ptr : ptrs) {
+	  ptr = static_cast<uint64_t *>(MEM_POOL()->getBuffer(id));
+	  *ptr = 1;
+	}
+	std::vector<uint32_t> order(benchTlbVolume_);
+	for (uint32_t i = 0; i < order.size(); ++i) {
+	  order[i] = i;
+	}
+	std::shuffle(order.begin(), order.end(), std::mt19937_64(id));
+
+	uint64_t sum = 0;
+	const auto start = Clock::now();
+	for (auto i : order) {
+	  sum += *ptrs[i];
+	}
+	const auto nsPerAccess = static_cast<double>(elapsedNs(start)) / order.size();
+
+	std::cout << std::setw(18) << slabBackingName(backing) << std::setw(16) << std::fixed << std::setprecision(2)
+			  << nsPerAccess << std::setw(10) << (sum == order.size() ? "ok" : "bad") << std::endl;
+	MemPool::returnBuffers(reinterpret_cast<void **>(ptrs.data()), ptrs.size());
+  }
+
+  void benchPageSizes() {
+	std::cout << "Random reads over " << benchTlbVolume_ << " x " << benchTlbObjectSize_
+			  << "B live objects by requested slab backing (stats below show what each pool got)" << std::endl;
+	std::cout << std::setw(18) << "requested" << std::setw(16) << "ns/access" << std::endl;
+	// Fresh thread so the stats only list these pools
+	std::thread([]() {
+	  benchPageSize(10, SlabBacking::RESERVED);
+	  benchPageSize(11, SlabBacking::HUGE_TRANSPARENT);
+	  benchPageSize(12, SlabBacking::HUGE_TLB);
+	  std::cout << MEM_POOL()->stats(true) << std::endl;
+	}).join();
+  }
+
+  constexpr auto benchCompareId_ = 20;
+  constexpr auto benchCompareCalls_ = 1000000;// Timed get+put calls per case
+  constexpr auto benchCompareWindow_ = 1024;  // Live objects kept by the steady-state patterns
+  constexpr auto benchCompareMaxBurst_ = 512;
+  constexpr auto benchQueueDepth_ = 4096;     // Producer/consumer hand-off ring
+  constexpr size_t benchMixedSizes_[] = {16, 24, 32, 48, 64, 96, 128, 256, 512, 1024, 2048, 4096};
+
+  /// @brief Latency of every call of a case and the wall time of the timed part
+  typedef struct Result {
+	Samples_t samples_;
+	uint64_t ns_ {};
+  } Result_t;
+
+  struct MallocAllocator {
+	static const char *name() { return "malloc"; }
+	void *get(size_t size) { return malloc(size); }
+	void put(void *ptr, size_t) { free(ptr); }
+  };
+
+  /// @brief getBuffer/returnBuffer for the registered size, allocate() for the mixed sizes
+  struct MemPoolAllocator {
+	static const char *name() { return "MemPool"; }
+	MemPoolAllocator() {
+	  MEM_POOL()->setPerObjectCount(benchVolume_);
+	  MEM_POOL()->registerNewObject(benchCompareId_, benchObjectSize_);
+	}
+	void *get(size_t size) {
+	  return (size == benchObjectSize_) ? MEM_POOL()->getBuffer(benchCompareId_) : MEM_POOL()->allocate(size);
+	}
+	void put(void *ptr, size_t) { MemPool::returnBuffer(ptr); }
+  };
+
+  /// @brief unsynchronized_pool_resource can't take frees from another thread; the cross-thread case uses the synchronized one
+  template<typename Resource>
+  struct PmrAllocator {
+	static const char *name() {
+	  return std::is_same<Resource, std::pmr::synchronized_pool_resource>::value ? "pmr sync" : "pmr unsync";
+	}
+	void *get(size_t size) { return resource_.allocate(size); }
+	void put(void *ptr, size_t size) { resource_.deallocate(ptr, size); }
+	Resource resource_;
+  };
+
+  template<typename Alloc>
+  void *timedGet(Alloc &alloc, size_t size, Samples_t &samples) {
+	const auto start = Clock::now();
+	auto ptr = alloc.get(size);
+	samples.push_back(elapsedNs(start));
+	return ptr;
+  }
+
+  template<typename Alloc>
+  void timedPut(Alloc &alloc, void *ptr, size_t size, Samples_t &samples) {
+	const auto start = Clock::now();
+	alloc.put(ptr, size);
+	samples.push_back(elapsedNs(start));
+  }
+
+  /// @brief Steady state: replace the oldest of a window of live objects, one size
+  template<typename Alloc>
+  void patternSingle(Alloc &alloc, Result_t &result) {
+	std::vector<void *> window(benchCompareWindow_, nullptr);
+	const auto start = Clock::now();
+	for (size_t i = 0; result.samples_.size() < benchCompareCalls_; ++i) {
+	  auto &slot = window[i % window.size()];
+	  if (slot != nullptr) {
+		timedPut(alloc, slot, benchObjectSize_, result.samples_);
+	  }
+	  slot = timedGet(alloc, benchObjectSize_, result.samples_);
+	}
+	result.ns_ = elapsedNs(start);
+	for (auto ptr : window) {
+	  alloc.put(ptr, benchObjectSize_);
+	}
+  }
+
+  /// @brief Allocate a burst of random length, then free it in random order
+  template<typename Alloc>
+  void patternBursty(Alloc &alloc, Result_t &result) {
+	std::mt19937_64 rng(benchCompareId_);
+	std::uniform_int_distribution<size_t> burstLength(1, benchCompareMaxBurst_);
+	std::vector<void *> burst;
+	const auto start = Clock::now();
+	while (result.samples_.size() < benchCompareCalls_) {
+	  burst.resize(burstLength(rng));
+	  for (auto &ptr : burst) {
+		ptr = timedGet(alloc, benchObjectSize_, result.samples_);
+	  }
+	  std::shuffle(burst.begin(), burst.end(), rng);
+	  for (auto ptr : burst) {
+		timedPut(alloc, ptr, benchObjectSize_, result.samples_);
+	  }
+	}
+	result.ns_ = elapsedNs(start);
+  }
+
+  /// @brief Replace a random object of a window of live objects with one of a random size, small sizes most likely
+  template<typename Alloc>
+  void patternMixed(Alloc &alloc, Result_t &result) {
+	std::mt19937_64 rng(benchCompareId_);
+	std::geometric_distribution<size_t> sizeIndex(0.3);
+	std::uniform_int_distribution<size_t> pick(0, benchCompareWindow_ - 1);
+	constexpr auto sizeCount = sizeof(benchMixedSizes_) / sizeof(benchMixedSizes_[0]);
+	std::vector<std::pair<void *, size_t>> window(benchCompareWindow_, {nullptr, 0});
+	const auto start = Clock::now();
+	while (result.samples_.size() < benchCompareCalls_) {
+	  auto &slot = window[pick(rng)];
+	  if (slot.first != nullptr) {
+		timedPut(alloc, slot.first, slot.second, result.samples_);
+	  }
+	  slot.second = benchMixedSizes_[std::min(sizeIndex(rng), sizeCount - 1)];
+	  slot.first = timedGet(alloc, slot.second, result.samples_);
+	}
+	result.ns_ = elapsedNs(start);
+	for (auto &slot : window) {
+	  if (slot.first != nullptr) {
+		alloc.put(slot.first, slot.second);
+	  }
+	}
+  }
+
+  /// @brief Allocate on this thread and free on a consumer thread through a ring, like MemPoolTest's processorThread
+  template<typename Alloc>
+  void patternCrossThread(Alloc &alloc, Result_t &result) {
+	std::vector<std::atomic<void *>> ring(benchQueueDepth_);
+	Samples_t putSamples;
+	putSamples.reserve(benchCompareCalls_ / 2);
+	const auto objects = benchCompareCalls_ / 2;
+	const auto start = Clock::now();
+	std::thread consumer([&]() {
+	  for (size_t i = 0; i < objects; ++i) {
+		auto &slot = ring[i % ring.size()];
+		void *ptr;
+		while ((ptr = slot.exchange(nullptr, std::memory_order_acquire)) == nullptr) {
+		  std::this_thread::yield();
+		}
+		timedPut(alloc, ptr, benchObjectSize_, putSamples);
+	  }
+	});
+	for (size_t i = 0; i < objects; ++i) {
+	  auto ptr = timedGet(alloc, benchObjectSize_, result.samples_);
+	  auto &slot = ring[i % ring.size()];
+	  while (slot.load(std::memory_order_relaxed) != nullptr) {
+		std::this_thread::yield();
+	  }
+	  slot.store(ptr, std::memory_order_release);
+	}
+	consumer.join();
+	result.ns_ = elapsedNs(start);
+	result.samples_.insert(result.samples_.end(), putSamples.begin(), putSamples.end());
+  }
+
+  /// @brief Run one pattern against one allocator on a fresh thread and print its row
+  template<typename Alloc, typename Pattern>
+  void runCase(const char *pattern, Pattern run) {
+	Result_t result;
+	result.samples_.reserve(benchCompareCalls_ + benchCompareMaxBurst_ * 2);
+	std::thread([&]() {
+	  Alloc alloc;
+	  run(alloc, result);
+	}).join();
+	std::cout << std::setw(12) << pattern << std::setw(12) << Alloc::name() << std::setw(12) << std::fixed
+			  << std::setprecision(2) << mopsPerSec(result.samples_.size(), result.ns_)
+			  << std::setw(10) << percentile(result.samples_, 0.50) << std::setw(10) << percentile(result.samples_, 0.99)
+			  << std::setw(10) << percentile(result.samples_, 0.999) << std::endl;
+  }
+
+  void benchCompare() {
+	std::cout << "MemPool vs malloc vs std::pmr, " << benchCompareCalls_
+			  << " timed get/put calls per case (Mops/s includes the timer; latency in ns)" << std::endl;
+	std::cout << std::setw(12) << "pattern" << std::setw(12) << "allocator" << std::setw(12) << "Mops/s"
+			  << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p999" << std::endl;
+	using PmrUnsync = PmrAllocator<std::pmr::unsynchronized_pool_resource>;
+	using PmrSync = PmrAllocator<std::pmr::synchronized_pool_resource>;
+	runCase<MemPoolAllocator>("single", patternSingle<MemPoolAllocator>);
+	runCase<MallocAllocator>("single", patternSingle<MallocAllocator>);
+	runCase<PmrUnsync>("single", patternSingle<PmrUnsync>);
+	runCase<MemPoolAllocator>("cross", patternCrossThread<MemPoolAllocator>);
+	runCase<MallocAllocator>("cross", patternCrossThread<MallocAllocator>);
+	runCase<PmrSync>("cross", patternCrossThread<PmrSync>);
+	runCase<MemPoolAllocator>("bursty", patternBursty<MemPoolAllocator>);
+	runCase<MallocAllocator>("bursty", patternBursty<MallocAllocator>);
+	runCase<PmrUnsync>("bursty", patternBursty<PmrUnsync>);
+	runCase<MemPoolAllocator>("mixed", patternMixed<MemPoolAllocator>);
+	runCase<MallocAllocator>("mixed", patternMixed<MallocAllocator>);
+	runCase<PmrUnsync>("mixed", patternMixed<PmrUnsync>);
+  }
+
+  /// @brief Pile remote frees into a nearly full pool, then time the owner's getBuffer calls that settle them
+  void benchHouseKeepingBudget(const char *label, size_t entries, uint64_t micros) {
+	std::thread owner([=]() {
+	  MEM_POOL()->setPerObjectCount(benchVolume_);
+	  MEM_POOL()->setHouseKeepingBudget(entries, micros);
+	  MEM_POOL()->registerNewObject(5, benchObjectSize_);
+	  // Past the upper threshold, so housekeeping is mandatory however busy the owner is
+	  std::vector<void *> ptrs(benchVolume_ * 0.97);
+	  for (auto &ptr : ptrs) {
+		ptr = MEM_POOL()->getBuffer(5);
+	  }
+	  std::thread([&]() {
+		for (size_t i = 0; i < benchRemoteFrees_; ++i) {
+		  MemPool::returnBuffer(ptrs[i]);
+		}
+	  }).join();
+	  std::this_thread::sleep_for(std::chrono::milliseconds(benchIdleMs_));// Idle time a reclaimer can use
+
+	  Samples_t samples;
+	  samples.reserve(benchRemoteFrees_);
+	  const auto drainStart = Clock::now();
+	  uint64_t drainNs = 0;
+	  for (size_t i = 0; i < benchRemoteFrees_; ++i) {
+		const auto start = Clock::now();
+		ptrs[i] = MEM_POOL()->getBuffer(5);
+		samples.push_back(elapsedNs(start));
+		if (drainNs == 0 && MEM_POOL()->threadStats().pendingRemoteReturns_ == 0) {
+		  drainNs = elapsedNs(drainStart);
+		}
+	  }
+	  const auto worst = *std::max_element(samples.begin(), samples.end());
+	  std::cout << std::setw(14) << label << std::setw(10) << percentile(samples, 0.50)
+				<< std::setw(10) << percentile(samples, 0.99) << std::setw(10) << percentile(samples, 0.999)
+				<< std::setw(12) << worst << std::setw(12) << (drainNs / 1000) << std::endl;
+	  for (auto ptr : ptrs) {
+		MemPool::returnBuffer(ptr);
+	  }
+	});
+	owner.join();
+  }
+
+  void benchHouseKeeping() {
+	std::cout << "getBuffer latency (ns) while settling " << benchRemoteFrees_
+			  << " remote frees, by housekeeping budget (drain = us until the inbox is empty)" << std::endl;
+	std::cout << std::setw(14) << "budget" << std::setw(10) << "p50" << std::setw(10) << "p99"
+			  << std::setw(10) << "p999" << std::setw(12) << "max" << std::setw(12) << "drain us" << std::endl;
+	benchHouseKeepingBudget("unlimited", 0, 0);
+	benchHouseKeepingBudget("4096 entries", 4096, 0);
+	benchHouseKeepingBudget("512 entries", 512, 0);
+	benchHouseKeepingBudget("64 entries", 64, 0);
+	benchHouseKeepingBudget("20 us", 0, 20);
+	benchHouseKeepingBudget("200 us", 0, 200);
+	benchHouseKeepingBudget("default", houseKeepingSlice_, houseKeepingBudgetUs_);
+  }
+
+  /// @brief Same pile of remote frees, settled inline by the owner vs by the background reclaimer
+  void benchReclaimer() {
+	std::cout << "getBuffer latency (ns) while taking back " << benchRemoteFrees_
+			  << " remote frees, housekeeping inline vs on the reclaimer thread (drain = us until the inbox is empty)"
+			  << std::endl;
+	std::cout << std::setw(14) << "mode" << std::setw(10) << "p50" << std::setw(10) << "p99"
+			  << std::setw(10) << "p999" << std::setw(12) << "max" << std::setw(12) << "drain us" << std::endl;
+	benchHouseKeepingBudget("inline", houseKeepingSlice_, houseKeepingBudgetUs_);
+	MemPool::startReclaimer();
+	benchHouseKeepingBudget("reclaimer", houseKeepingSlice_, houseKeepingBudgetUs_);
+	MemPool::stopReclaimer();
+  }
+
+  constexpr auto benchLockOps_ = 2000000;// Lock/unlock pairs per case, split over the threads
+  constexpr size_t benchLockThreads_[] = {1, 2, 4, 8, 16, 32, 64};
+
+  /// @brief std::mutex with the same interface as our locks, and no counters
+  struct StdMutex {
+	void lock() { mutex_.lock(); }
+	void unlock() { mutex_.unlock(); }
+	std::mutex mutex_;
+  };
+
+  template<typename Lock>
+  LockStats_t lockStats(const Lock &lock) { return lock.get_stats(); }
+
+  template<>
+  LockStats_t lockStats(const StdMutex &) { return {}; }
+
+  /// @brief `threads` threads taking turns on one lock around a tiny critical section
+  template<typename Lock>
+  void benchLock(const char *name, size_t threads) {
+	Lock lock;
+	uint64_t shared = 0;
+	const auto perThread = benchLockOps_ / threads;
+	std::vector<std::thread> workers;
+	const auto start = Clock::now();
+	for (size_t t = 0; t < threads; ++t) {
+	  workers.emplace_back([&]() {
+		for (size_t i = 0; i < perThread; ++i) {
+		  lock.lock();
+		  ++shared;
+		  lock.unlock();
+		}
+	  });
+	}
+	for (auto &worker : workers) {
+	  worker.join();
+	}
+	const auto ns = elapsedNs(start);
+	const auto contention = lockStats(lock);
+	std::cout << std::setw(12) << name << std::setw(9) << threads << std::setw(12) << std::fixed << std::setprecision(2)
+			  << mopsPerSec(shared, ns) << std::setw(12) << contention.contendedCount_ << std::setw(12)
+			  << contention.spinCount_ << std::setw(12) << contention.yieldCount_ << std::setw(12)
+			  << contention.sleepCount_ << std::endl;
+  }
+
+  void benchLocks() {
+	std::cout << "Lock throughput (Mops/s), " << benchLockOps_ << " lock/unlock pairs split over N threads, on "
+			  << std::thread::hardware_concurrency() << " CPUs" << std::endl;
+	std::cout << std::setw(12) << "lock" << std::setw(9) << "threads" << std::setw(12) << "Mops/s" << std::setw(12)
+			  << "contended" << std::setw(12) << "spins" << std::setw(12) << "yields" << std::setw(12) << "sleeps"
+			  << std::endl;
+	for (auto threads : benchLockThreads_) {
+	  benchLock<SpinLock>("SpinLock", threads);
+	  benchLock<TicketLock>("TicketLock", threads);
+	  benchLock<StdMutex>("std::mutex", threads);
+	}
+  }
+
+  constexpr auto benchQueueItems_ = 1000000;// Items per case, split over the producers
+  constexpr size_t benchQueueProducers_[] = {1, 2, 4, 8};
+
+  /// @brief LockLessQ with nodes taken from the producer's MemPool and given back by the consumer
+  struct PooledNodeQ {
+	static const char *name() { return "MPSC pooled"; }
+	void producerStart() { MEM_POOL()->registerType<PointerNode>(); }
+	bool push(void *item) {
+	  queue_.enqueue(new (MEM_POOL()->getBuffer<PointerNode>()) PointerNode(item));
+	  return true;
+	}
+	bool pop(void *&item) {
+	  const auto node = queue_.dequeue();
+	  if (node == nullptr) {
+		return false;
+	  }
+	  item = node->ptr_;
+	  MemPool::returnBuffer(node);
+	  return true;
+	}
+	LockLessQ<PointerNode> queue_;
+  };
+
+  /// @brief LockLessQ with nodes from new/delete
+  struct HeapNodeQ {
+	static const char *name() { return "MPSC new"; }
+	void producerStart() {}
+	bool push(void *item) {
+	  queue_.enqueue(new PointerNode(item));
+	  return true;
+	}
+	bool pop(void *&item) {
+	  const auto node = queue_.dequeue();
+	  if (node == nullptr) {
+		return false;
+	  }
+	  item = node->ptr_;
+	  delete node;
+	  return true;
+	}
+	LockLessQ<PointerNode> queue_;
+  };
+
+  struct RingQ {
+	static const char *name() { return "MPMC ring"; }
+	void producerStart() {}
+	bool push(void *item) { return queue_.enqueue(item); }
+	bool pop(void *&item) { return queue_.dequeue(item); }
+	BoundedLockLessQ<void *> queue_ {benchQueueDepth_};
+  };
+
+  struct MutexQ {
+	static const char *name() { return "mutex+deque"; }
+	void producerStart() {}
+	bool push(void *item) {
+	  const std::lock_guard<std::mutex> guard(mutex_);
+	  queue_.push_back(item);
+	  return true;
+	}
+	bool pop(void *&item) {
+	  const std::lock_guard<std::mutex> guard(mutex_);
+	  if (queue_.empty()) {
+		return false;
+	  }
+	  item = queue_.front();
+	  queue_.pop_front();
+	  return true;
+	}
+	std::mutex mutex_;
+	std::deque<void *> queue_;
+  };
+
+  /// @brief `producers` threads pushing into one queue drained by a single consumer
+  template<typename Queue>
+  void benchQueue(size_t producers) {
+	Queue queue;
+	const auto perProducer = benchQueueItems_ / producers;
+	const auto total = perProducer * producers;
+	std::vector<std::thread> threads;
+	const auto start = Clock::now();
+	for (size_t p = 0; p < producers; ++p) {
+	  threads.emplace_back([&]() {
+		queue.producerStart();
+		for (size_t i = 1; i <= perProducer; ++i) {
+		  while (!queue.push((void *)i)) {
+			std::this_thread::yield();// Full ring
+		  }
+		}
+	  });
+	}
+	uint64_t checksum = 0;
+	void *item;
+	for (size_t popped = 0; popped < total;) {
+	  if (queue.pop(item)) {
+		checksum += (uintptr_t)item;
+		++popped;
+	  } else {
+		std::this_thread::yield();
+	  }
+	}
+	for (auto &thread : threads) {
+	  thread.join();
+	}
+	const auto ns = elapsedNs(start);
+	if (checksum != producers * (perProducer * (perProducer + 1) / 2)) {
+	  std::cerr << __func__ << " [ERROR] " << Queue::name() << " lost or duplicated items" << std::endl;
+	}
+	std::cout << std::setw(14) << Queue::name() << std::setw(11) << producers << std::setw(12) << std::fixed
+			  << std::setprecision(2) << mopsPerSec(total, ns) << std::endl;
+  }
+
+  void benchQueues() {
+	std::cout << "Queue throughput (Mitems/s), " << benchQueueItems_ << " items split over N producers, one consumer"
+			  << std::endl;
+	std::cout << std::setw(14) << "queue" << std::setw(11) << "producers" << std::setw(12) << "Mitems/s" << std::endl;
+	for (auto producers : benchQueueProducers_) {
+	  benchQueue<PooledNodeQ>(producers);
+	  benchQueue<HeapNodeQ>(producers);
+	  benchQueue<RingQ>(producers);
+	  benchQueue<MutexQ>(producers);
+	}
+  }
+
+  constexpr auto benchLookupCalls_ = 5000000;
+  constexpr auto benchLookupBurst_ = 256;// Objects got back to back, timed as one block, then returned untimed
+
+  struct LookupObject {
+	uint64_t fields_[8];
+  };
+
+  /// @brief Average ns of one `get`, timed in bursts so that the clock and the returns stay out of the figure
+  template<typename Get>
+  void benchLookupPath(const char *name, Get get) {
+	void *ptrs[benchLookupBurst_];
+	uint64_t ns = 0;
+	for (auto round = 0; round < benchLookupCalls_ / benchLookupBurst_; ++round) {
+	  const auto start = Clock::now();
+	  for (auto &ptr : ptrs) {
+		ptr = get();
+	  }
+	  ns += elapsedNs(start);
+	  MemPool::returnBuffers(ptrs, benchLookupBurst_);
+	}
+	std::cout << std::setw(28) << name << std::setw(12) << std::fixed << std::setprecision(1)
+			  << (double)ns / (benchLookupCalls_ / benchLookupBurst_ * benchLookupBurst_) << std::endl;
+  }
+
+  void benchLookup() {
+	std::cout << "getBuffer (ns), by the way the pool of a type is found" << std::endl;
+	std::cout << std::setw(28) << "path" << std::setw(12) << "ns/get" << std::endl;
+	std::thread([]() {
+	  const int id = typeid(LookupObject).hash_code();
+	  MEM_POOL()->registerType<LookupObject>();
+	  benchLookupPath("getBuffer(id), hashed", [id]() { return MEM_POOL()->getBuffer(id); });
+	  benchLookupPath("getBuffer<T>(), type slot", []() { return MEM_POOL()->getBuffer<LookupObject>(); });
+	  benchLookupPath("mem::make_unique<T>()", []() { return mem::make_unique<LookupObject>().release(); });
+	}).join();
+  }
+
+  constexpr auto benchContainerNodes_ = 100000;// Nodes inserted then erased per round
+  constexpr auto benchContainerRounds_ = 20;
+
+  /// @brief Insert and erase `benchContainerNodes_` random keys into a map built by `make`
+  template<typename MakeMap>
+  double benchMap(MakeMap make) {
+	std::mt19937_64 rng(benchContainerNodes_);
+	std::vector<int> keys(benchContainerNodes_);
+	for (auto &key : keys) {
+	  key = (int)rng();
+	}
+	auto map = make();
+	const auto start = Clock::now();
+	for (auto round = 0; round < benchContainerRounds_; ++round) {
+	  for (auto key : keys) {
+		map.emplace(key, key);
+	  }
+	  for (auto key : keys) {
+		map.erase(key);
+	  }
+	}
+	return mopsPerSec(2 * benchContainerNodes_ * benchContainerRounds_, start);
+  }
+
+  /// @brief Push `benchContainerNodes_` values into a list built by `make`, then erase every other one and the rest
+  template<typename MakeList>
+  double benchList(MakeList make) {
+	auto list = make();
+	const auto start = Clock::now();
+	for (auto round = 0; round < benchContainerRounds_; ++round) {
+	  for (auto i = 0; i < benchContainerNodes_; ++i) {
+		list.push_back(i);
+	  }
+	  for (auto itr = list.begin(); itr != list.end();) {
+		itr = list.erase(itr);
+		if (itr != list.end()) {
+		  ++itr;
+		}
+	  }
+	  list.clear();
+	}
+	return mopsPerSec(2 * benchContainerNodes_ * benchContainerRounds_, start);
+  }
+
+  template<typename MakeMap, typename MakeList>
+  void benchContainer(const char *name, MakeMap makeMap, MakeList makeList) {
+	double map = 0, list = 0;
+	std::thread([&]() {
+	  map = benchMap(makeMap);
+	  list = benchList(makeList);
+	}).join();
+	std::cout << std::setw(22) << name << std::setw(12) << std::fixed << std::setprecision(2) << map << std::setw(12)
+			  << list << std::endl;
+  }
+
+  void benchContainers() {
+	std::cout << "std::map / std::list insert + erase (Mops/s), " << benchContainerNodes_ << " nodes x "
+			  << benchContainerRounds_ << " rounds" << std::endl;
+	std::cout << std::setw(22) << "allocator" << std::setw(12) << "map" << std::setw(12) << "list" << std::endl;
+	benchContainer(
+		"std::allocator", []() { return std::map<int, int>(); }, []() { return std::list<int>(); });
+	benchContainer(
+		"mem::PoolAllocator",
+		[]() { return std::map<int, int, std::less<>, mem::PoolAllocator<std::pair<const int, int>>>(); },
+		[]() { return std::list<int, mem::PoolAllocator<int>>(); });
+	benchContainer(
+		"pmr MemPoolResource", []() { return std::pmr::map<int, int>(mem::pool_resource()); },
+		[]() { return std::pmr::list<int>(mem::pool_resource()); });
+	// The pool resources must outlive their containers; one per benchmark thread is enough
+	benchContainer(
+		"pmr unsync pool",
+		[]() {
+		  static thread_local std::pmr::unsynchronized_pool_resource pool;
+		  return std::pmr::map<int, int>(&pool);
+		},
+		[]() {
+		  static thread_local std::pmr::unsynchronized_pool_resource pool;
+		  return std::pmr::list<int>(&pool);
+		});
+  }
+
+  constexpr auto benchSharedCalls_ = 2000000;
+
+  struct SharedObject {
+	uint64_t fields_[4];
+	explicit SharedObject(uint64_t value) : fields_ {value, value, value, value} {}
+  };
+
+  /// @brief Make/destroy and copy/destroy costs of one shared pointer flavour, and heap allocations per make
+  template<typename Make>
+  void benchSharedPtr(const char *name, Make make) {
+	std::thread([&]() {
+	  make(0);// Registers the pool, outside of the timing
+	  const auto allocationsBefore = gHeapAllocations;
+	  auto start = Clock::now();
+	  for (auto i = 0; i < benchSharedCalls_; ++i) {
+		auto ptr = make(i);
+	  }
+	  const auto makeNs = (double)elapsedNs(start) / benchSharedCalls_;
+	  const auto allocations = (double)(gHeapAllocations - allocationsBefore) / benchSharedCalls_;
+
+	  const auto original = make(1);
+	  start = Clock::now();
+	  for (auto i = 0; i < benchSharedCalls_; ++i) {
+		auto copy = original;
+	  }
+	  const auto copyNs = (double)elapsedNs(start) / benchSharedCalls_;
+	  std::cout << std::setw(24) << name << std::setw(14) << std::fixed << std::setprecision(1) << makeNs
+				<< std::setw(14) << copyNs << std::setw(16) << std::setprecision(2) << allocations << std::endl;
+	}).join();
+  }
+
+  void benchSharedPtrs() {
+	std::cout << "Shared pointers: ns per make + destroy, ns per copy + destroy, heap allocations per make" << std::endl;
+	std::cout << std::setw(24) << "flavour" << std::setw(14) << "make ns" << std::setw(14) << "copy ns"
+			  << std::setw(16) << "heap allocs" << std::endl;
+	benchSharedPtr("std::make_shared", [](uint64_t i) { return std::make_shared<SharedObject>(i); });
+	benchSharedPtr("mem::make_shared", [](uint64_t i) { return mem::make_shared<SharedObject>(i); });
+	benchSharedPtr("mem::make_local_shared", [](uint64_t i) { return mem::make_local_shared<SharedObject>(i); });
+  }
+
+  constexpr auto benchZeroCalls_ = 1000000;
+  constexpr size_t benchZeroHotLive_ = 64;   // Slots cycled through while they are still cached
+  constexpr size_t benchZeroColdLive_ = 8192;// Slots cycled through once they have left the cache, for large sizes
+
+  /// @brief ns per getBuffer + returnBuffer of an object of `size` bytes under `zero`, cycling through `live` slots
+  /// @note Only the first cache line of an object is written, as a message header would be
+  double benchZeroPolicy(size_t size, ZeroPolicy zero, size_t live) {
+	double ns = 0;
+	std::thread([&]() {
+	  PoolConfig_t config {{GrowthPolicy_t::NONE, 0, 0}, SlabBacking::HEAP};
+	  config.zero_ = zero;
+	  MEM_POOL()->setPerObjectCount(live * 4);
+	  MEM_POOL()->registerNewObject(1, size, config);
+	  std::vector<void *> slots(live, nullptr);
+	  const auto start = Clock::now();
+	  for (auto i = 0; i < benchZeroCalls_; ++i) {
+		auto &slot = slots[i % live];
+		MemPool::returnBuffer(slot);
+		slot = MEM_POOL()->getBuffer(1);
+		memset(slot, i, std::min<size_t>(size, 64));
+	  }
+	  ns = (double)elapsedNs(start) / benchZeroCalls_;
+	  MemPool::returnBuffers(slots.data(), live);
+	}).join();
+	return ns;
+  }
+
+  void benchZeroPolicies() {
+	const ZeroPolicy policies[] = {ZeroPolicy::NONE, ZeroPolicy::ON_ALLOC, ZeroPolicy::ON_FREE, ZeroPolicy::ON_FREE_NT};
+	for (auto live : {benchZeroHotLive_, benchZeroColdLive_}) {
+	  std::cout << "Zero policies: ns per getBuffer + returnBuffer by object size, " << live << " live objects"
+				<< std::endl;
+	  std::cout << std::setw(8) << "size";
+	  for (auto zero : policies) {
+		std::cout << std::setw(14) << zeroPolicyName(zero);
+	  }
+	  std::cout << std::endl;
+	  for (size_t size : {64, 256, 1024, 2048, 4096}) {
+		std::cout << std::setw(8) << size;
+		for (auto zero : policies) {
+		  std::cout << std::setw(14) << std::fixed << std::setprecision(1) << benchZeroPolicy(size, zero, live);
+		}
+		std::cout << std::endl;
+	  }
+	}
+  }
+
+  constexpr auto benchShareObjects_ = 64;       // Counters handed round-robin to the worker threads
+  constexpr auto benchShareIncrements_ = 20000000;// Increments per worker
+  constexpr auto benchWalkObjects_ = 16000;    // 48 byte objects visited at random by the straddle run; about 1MiB
+  constexpr auto benchWalkObjectSize_ = 48;
+
+  struct SharedCounter {
+	std::atomic<uint64_t> value_;
+	uint64_t owner_;
+  };
+
+  /// @brief Million increments per second of worker threads that each own every n-th counter of one pool
+  double benchFalseSharing(int id, bool padded) {
+	const auto workers = std::max(2u, std::thread::hardware_concurrency());
+	MEM_POOL()->setCacheLinePadding(padded);
+	MEM_POOL()->registerNewObject(id, sizeof(SharedCounter), alignof(SharedCounter));
+	MEM_POOL()->setCacheLinePadding(false);
+	SharedCounter *counters[benchShareObjects_];
+	for (auto &counter : counters) {
+	  counter = new (MEM_POOL()->getBuffer(id)) SharedCounter {{0}, 0};
+	}
+	std::vector<std::thread> threads;
+	const auto start = Clock::now();
+	for (unsigned w = 0; w < workers; ++w) {
+	  threads.emplace_back([&counters, w, workers]() {
+		const auto owned = benchShareObjects_ / workers;// Counters w, w + workers, w + 2 * workers, ...
+		for (auto i = 0; i < benchShareIncrements_; ++i) {
+		  counters[w + ((i % owned) * workers)]->value_.fetch_add(1, std::memory_order_relaxed);
+		}
+	  });
+	}
+	for (auto &thread : threads) {
+	  thread.join();
+	}
+	const auto ns = elapsedNs(start);
+	MemPool::returnBuffers((void **)counters, benchShareObjects_);
+	return ((double)workers * benchShareIncrements_ * 1000) / ns;
+  }
+
+  /// @brief ns per random visit of a 48 byte object, and the share of objects that straddle two cache lines
+  double benchStraddle(int id, bool padded, double &straddling) {
+	MEM_POOL()->setPerObjectCount(benchWalkObjects_);
+	MEM_POOL()->setCacheLinePadding(padded);
+	MEM_POOL()->registerNewObject(id, benchWalkObjectSize_);
+	MEM_POOL()->setCacheLinePadding(false);
+	std::vector<uint64_t *> objects(benchWalkObjects_);
+	size_t crossing = 0;
+	for (auto &object : objects) {
+	  object = MEM_POOL()->getBuffer<uint64_t>(id);
+	  crossing += ((uintptr_t)object / cacheLineBytes_) != (((uintptr_t)object + benchWalkObjectSize_ - 1) / cacheLineBytes_);
+	}
+	straddling = (double)crossing / benchWalkObjects_;
+	std::shuffle(objects.begin(), objects.end(), std::mt19937_64(id));
+	uint64_t sum = 0;
+	const auto start = Clock::now();
+	for (auto round = 0; round < 10; ++round) {
+	  for (auto object : objects) {
+		for (size_t word = 0; word < benchWalkObjectSize_ / sizeof(uint64_t); ++word) {
+		  sum += object[word]++;
+		}
+	  }
+	}
+	const auto ns = (double)elapsedNs(start) / (10.0 * benchWalkObjects_);
+	MemPool::returnBuffers(objects.data(), objects.size());
+	if (sum == 1) {
+	  std::cout << "";// Keep the walk from being optimized away
+	}
+	return ns;
+  }
+
+  void benchAlignment() {
+	std::thread([]() {
+	  std::cout << "Cache line padding, " << std::max(2u, std::thread::hardware_concurrency())
+				<< " workers incrementing counters of one pool (Mops/s)" << std::endl;
+	  std::cout << std::setw(12) << "unpadded" << std::setw(12) << std::fixed << std::setprecision(1)
+				<< benchFalseSharing(1, false) << std::endl;
+	  std::cout << std::setw(12) << "padded" << std::setw(12) << benchFalseSharing(2, true) << std::endl;
+	  std::cout << "Random visits of " << benchWalkObjectSize_ << " byte objects (ns per object, % straddling)"
+				<< std::endl;
+	  double straddling = 0;
+	  for (auto padded : {false, true}) {
+		const auto ns = benchStraddle(padded ? 4 : 3, padded, straddling);
+		std::cout << std::setw(12) << (padded ? "padded" : "unpadded") << std::setw(12) << std::setprecision(1) << ns
+				  << std::setw(10) << std::setprecision(0) << (straddling * 100) << "%" << std::endl;
+	  }
+	}).join();
+  }
+}// namespace
+
+int main(int argc, char **argv) {
+  const std::string only = (argc > 1) ? argv[1] : "";
+  if (only.empty() || only == "occupancy") {
+	benchOccupancyLatency();
+  }
+  if (only.empty() || only == "batch") {
+	benchBatchThroughput();
+  }
+  if (only.empty() || only == "startup") {
+	benchStartupFootprint();
+  }
+  if (only.empty() || only == "hugepages") {
+	benchPageSizes();
+  }
+  if (only.empty() || only == "compare") {
+	benchCompare();
+  }
+  if (only.empty() || only == "housekeeping") {
+	benchHouseKeeping();
+  }
+  if (only.empty() || only == "reclaimer") {
+	benchReclaimer();
+  }
+  if (only.empty() || only == "locks") {
+	benchLocks();
+  }
+  if (only.empty() || only == "queues") {
+	benchQueues();
+  }
+  if (only.empty() || only == "lookup") {
+	benchLookup();
+  }
+  if (only.empty() || only == "containers") {
+	benchContainers();
+  }
+  if (only.empty() || only == "shared") {
+	benchSharedPtrs();
+  }
+  if (only.empty() || only == "zeroing") {
+	benchZeroPolicies();
+  }
+  if (only.empty() || only == "alignment") {
+	benchAlignment();
+  }
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "MemPoolTest.h"
+#include "../include/Base/Pages.h"
 #include "../include/Base/ThreadInfo.h"
 #include "../include/Memory/shared_ptr.h"
 #include "../include/Memory/unique_ptr.h"
@@ -35,7 +36,7 @@ void MemPoolTest::runTest() {
 	  auto node = dataQ_->dequeue();
 	  if (node != nullptr) {
 		MemPool::returnBuffer(node->ptr_);
-		delete node;
+		MemPool::returnBuffer(node);// The node came from the worker's MemPool as well
 	  }
 	}
 	usleep(10);
@@ -94,6 +95,7 @@ struct X {
   MEM_POOL()->registerType<ThreadsVecPtr_t>();
   MEM_POOL()->registerType<BufferData_t>();
   MEM_POOL()->registerType<BufferDataPtr_t>();
+  MEM_POOL()->registerType<PointerNode>();
 
   timespec sleepTime = {.tv_sec = 0, .tv_nsec = 3};
 
@@ -159,7 +161,8 @@ struct X {
 }
 
 void MemPoolTest::sendToInternalQ(void *sptr) {
-  dataQ_->enqueue(new PointerNode(sptr));
+  // No malloc on the way to the processor: the node is a pool slot, given back by whoever frees it
+  dataQ_->enqueue(new (MEM_POOL()->getBuffer<PointerNode>()) PointerNode(sptr));
 }
 
 void MemPoolTest::stopTest() {
@@ -170,7 +173,172 @@ void MemPoolTest::stopTest() {
   std::cout << "Test Suite Complete...!" << std::endl;
 }
 
+bool MemPoolTest::runChecks() {
+  bool passed = true;
+  passed &= checkNumaLocal();
+  passed &= checkSharedPtrAdopt();
+  passed &= checkUniquePtrBase();
+  return passed;
+}
+
+bool MemPoolTest::checkNumaLocal() {
+  // Single-node machines take the same path, with mbind a no-op; the node shown is then 0 or any
+  constexpr size_t volume = 64;
+  bool passed = true;
+  int id = 4000;
+  const auto poolOf = [](int _id) {
+	PoolStats_t pools[64];
+	const auto count = std::min(MEM_POOL()->poolStats(pools, 64), (size_t)64);
+	const auto pool = std::find_if(pools, pools + count, [_id](const PoolStats_t &stats) { return stats.id_ == _id; });
+	return (pool != pools + count) ? *pool : PoolStats_t {};
+  };
+  for (const auto backing : {SlabBacking::HEAP, SlabBacking::RESERVED}) {
+	PoolConfig_t config {{GrowthPolicy_t::FIXED, volume, 0}, backing};
+	config.numaLocal_ = true;
+	MEM_POOL()->setPerObjectCount(volume);
+	if (!MEM_POOL()->registerNewObject(++id, 256, config)) {
+	  std::cerr << __func__ << " [ERROR] Unable to register a NUMA local pool" << std::endl;
+	  return false;
+	}
+	std::vector<void *> buffers;
+	for (size_t i = 0; i < volume * 3; ++i) {
+	  auto ptr = MEM_POOL()->getBuffer(id);
+	  if (ptr == nullptr) {
+		std::cerr << __func__ << " [ERROR] getBuffer failed at " << i << std::endl;
+		passed = false;
+		break;
+	  }
+	  memset(ptr, 0x5a, 256);
+	  buffers.push_back(ptr);
+	}
+	const auto pool = poolOf(id);
+	if (pool.slabCount_ < 2 || pool.overflowCount_ != 0) {
+	  std::cerr << __func__ << " [ERROR] The pool did not grow into slabs of its own" << std::endl;
+	  passed = false;
+	}
+	// Every slab is on a node that exists, or unbound
+	const auto stats = MEM_POOL()->stats(true);
+	const auto entry = stats.find(" Pool ID: " + std::to_string(id) + "|");
+	const auto begin = stats.find(" Node: ", entry) + 7;
+	const auto nodes = stats.substr(begin, stats.find('|', begin) - begin);
+	std::stringstream names(nodes);
+	for (std::string name; std::getline(names, name, '+');) {
+	  if (name != "any" && (name.find_first_not_of("0123456789") != std::string::npos
+							|| std::stoul(name) >= base::numaNodeCount())) {
+		std::cerr << __func__ << " [ERROR] Slab on an invalid node: " << nodes << std::endl;
+		passed = false;
+	  }
+	}
+	if (entry == std::string::npos || nodes.empty()) {
+	  std::cerr << __func__ << " [ERROR] No node reported for the pool" << std::endl;
+	  passed = false;
+	}
+	for (const auto ptr : buffers) {
+	  MemPool::returnBuffer(ptr);
+	}
+	if (poolOf(id).inUse_ != 0) {
+	  std::cerr << __func__ << " [ERROR] " << poolOf(id).inUse_ << " buffers still in use after returning all" << std::endl;
+	  passed = false;
+	}
+	std::cout << __func__ << " backing: " << slabBackingName(backing) << " nodes: " << nodes
+			  << (passed ? " passed" : " FAILED") << std::endl;
+  }
+  MEM_POOL()->setPerObjectCount(defaultVolume_);
+  return passed;
+}
+
+namespace {
+  struct Counted {
+	static int destroyed_;
+	long payload_[4] {};
+	~Counted() { ++destroyed_; }
+  };
+
+  int Counted::destroyed_ = 0;
+
+  /// @brief Slots of this thread's pools that are out
+  size_t buffersInUse() {
+	PoolStats_t pools[64];
+	const auto count = std::min(MEM_POOL()->poolStats(pools, 64), (size_t)64);
+	size_t inUse = 0;
+	for (size_t i = 0; i < count; ++i) {
+	  inUse += pools[i].inUse_;
+	}
+	return inUse;
+  }
+
+  struct Left {
+	virtual ~Left() = default;
+	long left_ = 1;
+  };
+
+  struct Right {
+	virtual ~Right() = default;
+	long right_ = 2;
+  };
+
+  struct Both : Left, Right {
+	~Both() override { ++Counted::destroyed_; }
+	long both_ = 3;
+  };
+
+  struct Plain {
+	long plain_;
+  };
+
+  struct PlainDerived : Left, Plain {
+  };
+
+  // Without a virtual destructor the deleter could neither destroy all of it nor find the slot
+  static_assert(!std::is_constructible<mem::unique_ptr<Plain>, mem::unique_ptr<PlainDerived> &&>::value,
+				"a base without a virtual destructor must not take ownership");
+}// namespace
+
+bool MemPoolTest::checkSharedPtrAdopt() {
+  Counted::destroyed_ = 0;
+  {
+	auto fromNew = mem::shared_ptr<Counted>(new Counted());
+	auto copy = fromNew;
+	auto fromPool = mem::shared_ptr<Counted>(new (MEM_POOL()->getBuffer<Counted>()) Counted());
+  }
+  const auto inUse = buffersInUse();
+  const auto passed = (Counted::destroyed_ == 2) && (inUse == 0);
+  if (!passed) {
+	std::cerr << __func__ << " [ERROR] Destroyed " << Counted::destroyed_ << " of 2, " << inUse
+			  << " buffers still in use" << std::endl;
+  }
+  std::cout << __func__ << (passed ? " passed" : " FAILED") << std::endl;
+  return passed;
+}
+
+bool MemPoolTest::checkUniquePtrBase() {
+  Counted::destroyed_ = 0;
+  const void *slot = nullptr;
+  const void *base = nullptr;
+  {
+	auto both = mem::make_unique<Both>();
+	slot = both.get();
+	mem::unique_ptr<Right> right = std::move(both);
+	base = right.get();
+	mem::unique_ptr<Left> left;
+	left = mem::make_unique<Both>();
+  }
+  const auto inUse = buffersInUse();
+  const auto passed = (slot != base) && (Counted::destroyed_ == 2) && (inUse == 0);
+  if (!passed) {
+	std::cerr << __func__ << " [ERROR] Destroyed " << Counted::destroyed_ << " of 2, " << inUse
+			  << " buffers still in use" << std::endl;
+  }
+  std::cout << __func__ << (passed ? " passed" : " FAILED") << std::endl;
+  return passed;
+}
+
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) {
+  // kill -USR1 <pid> writes the pools of every thread to this file
+  MemPool::enableStatsDumpOnSignal("/tmp/MemPoolTest." + std::to_string(getpid()) + ".stats");
+  if (!MemPoolTest::runChecks()) {
+	return 1;
+  }
   MemPoolTest test(10);
   test.runTest();
   char x;
@@ -24,6 +24,10 @@ class MemPoolTest {
 
   void stopTest();
 
+  /// @brief Single threaded checks, run before the stress test
+  /// @returns false if any of them fails
+  static bool runChecks();
+
  private:
   static void sendToInternalQ(void *sptr);
 
@@ -31,6 +35,15 @@ class MemPoolTest {
 
   [[noreturn]] static void workerRoutine();
 
+  /// @brief A pool with numaLocal_ grows, reports a valid node for every slab and still hands out and takes back
+  static bool checkNumaLocal();
+
+  /// @brief mem::shared_ptr(T *) returns pool buffers to their pool and deletes objects from plain new
+  static bool checkSharedPtrAdopt();
+
+  /// @brief mem::unique_ptr to a second base, at a non-zero offset, still returns the whole slot
+  static bool checkUniquePtrBase();
+
  private:
   size_t threadCount_;
   std::thread procTid_;